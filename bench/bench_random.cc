@@ -0,0 +1,306 @@
+// Self-contained benchmarks for random.hpp
+//
+// Usage: bench_random [filter]
+// Only benchmarks whose name contains filter are run. Each benchmark is run
+// several times and the fastest run is reported, in ns per value and GB/s
+// of output. When built with -DRACUTILS_RANDOM_STATS, the sampler
+// statistics of the whole run are printed at the end.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../random.hpp"
+
+using namespace racutils::random;
+
+namespace {
+
+constexpr int REPEATS = 5;
+
+// keep the compiler from optimizing away a value
+template <typename T>
+inline void do_not_optimize(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+const char *filter = nullptr;
+
+bool selected(const std::string &name) { return filter == nullptr || name.find(filter) != std::string::npos; }
+
+void report(const std::string &name, double ns, size_t bytes) {
+    printf("%-40s %10.3f ns/value %9.3f GB/s\n", name.c_str(), ns, bytes / ns);
+    fflush(stdout);
+}
+
+// run f(n) REPEATS times and return the fastest time in ns per value
+template <typename F>
+double time_ns(size_t n, F &&f) {
+    double best = 1e300;
+    f(n / 16);  // warm up
+    for(int r = 0; r < REPEATS; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        f(n);
+        auto stop = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(stop - start).count() / n);
+    }
+    return best;
+}
+
+// benchmark a function that returns one value per call
+template <typename T, typename F>
+void bench(const std::string &name, size_t n, F &&f) {
+    if(!selected(name)) {
+        return;
+    }
+    double ns = time_ns(n, [&](size_t m) {
+        for(size_t i = 0; i < m; ++i) {
+            do_not_optimize(f());
+        }
+    });
+    report(name, ns, sizeof(T));
+}
+
+// benchmark a function that fills a buffer of values
+template <typename T, typename F>
+void bench_fill(const std::string &name, size_t n, F &&f) {
+    if(!selected(name)) {
+        return;
+    }
+    std::vector<T> buffer(4096);
+    double ns = time_ns(n, [&](size_t m) {
+        for(size_t i = 0; i < m; i += buffer.size()) {
+            f(buffer.data(), std::min(buffer.size(), m - i));
+            do_not_optimize(buffer[0]);
+        }
+    });
+    report(name, ns, sizeof(T));
+}
+
+// run bits() on num_threads threads with independent streams and report
+// the aggregate throughput
+void bench_threads(unsigned int num_threads, size_t n) {
+    std::string name = "bits/threads:" + std::to_string(num_threads);
+    if(!selected(name)) {
+        return;
+    }
+    StreamPool pool(SeedSeq256({1}));
+    auto streams = pool.Streams(num_threads);
+    double ns = time_ns(n, [&](size_t m) {
+        std::vector<std::thread> threads;
+        size_t per = m / num_threads;
+        for(unsigned int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                Random &rand = *streams[t];
+                for(size_t i = 0; i < per; ++i) {
+                    do_not_optimize(rand.bits());
+                }
+            });
+        }
+        for(auto &&th : threads) {
+            th.join();
+        }
+    });
+    report(name, ns, sizeof(uint64_t));
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    if(argc > 1) {
+        filter = argv[1];
+    }
+    constexpr size_t N = 1 << 24;
+    Random rand;
+    rand.Seed(123u);
+
+    bench<uint64_t>("bits", N, [&]() { return rand.bits(); });
+    bench<uint32_t>("u32", N, [&]() { return rand.u32(); });
+    for(uint64_t range : {UINT64_C(10), UINT64_C(1000003), (UINT64_C(1) << 32) + 1, (UINT64_C(1) << 63) + 1}) {
+        bench<uint64_t>("u64(range)/" + std::to_string(range), N, [&]() { return rand.u64(range); });
+    }
+    bench<double>("f52", N, [&]() { return rand.f52(); });
+    bench<double>("f53", N, [&]() { return rand.f53(); });
+    bench<float>("f23", N, [&]() { return rand.f23(); });
+    bench<float>("f24", N, [&]() { return rand.f24(); });
+    bench<std::pair<float, float>>("f24_pair", N, [&]() { return rand.f24_pair(); });
+    bench<double>("exp", N, [&]() { return rand.exp(); });
+    bench<double>("normal", N, [&]() { return rand.normal(); });
+
+    {
+        std::uniform_int_distribution<int> std_int(1, 1000003);
+        UniformIntDistribution<int> fast_int(1, 1000003);
+        std::uniform_real_distribution<double> std_real(0.0, 1.0);
+        UniformRealDistribution<double> fast_real(0.0, 1.0);
+        bench<int>("std::uniform_int_distribution", N, [&]() { return std_int(rand); });
+        bench<int>("UniformIntDistribution", N, [&]() { return fast_int(rand); });
+        bench<double>("std::uniform_real_distribution", N, [&]() { return std_real(rand); });
+        bench<double>("UniformRealDistribution", N, [&]() { return fast_real(rand); });
+    }
+
+    {
+        constexpr double p = 1e-6;
+        Bernoulli bernoulli(p);
+        bench<bool>("f52() < p", N, [&]() { return rand.f52() < p; });
+        bench<bool>("Bernoulli", N, [&]() { return bernoulli(rand); });
+        bench<uint64_t>("Geometric/1e-6", N, [&, geometric = Geometric(p)]() { return geometric(rand); });
+        // m successes are expected from m/p trials, so this is the time per success
+        if(selected("BernoulliSuccesses/1e-6")) {
+            double ns = time_ns(size_t{1} << 20, [&](size_t m) {
+                for(uint64_t i : BernoulliSuccesses(rand, p, static_cast<uint64_t>(m / p))) {
+                    do_not_optimize(i);
+                }
+            });
+            report("BernoulliSuccesses/1e-6", ns, sizeof(uint64_t));
+        }
+    }
+
+    bench_fill<uint64_t>("fill_u64", N, [&](uint64_t *out, size_t n) { rand.fill_u64(out, n); });
+    bench_fill<uint64_t>("u64_fill/1000003", N, [&](uint64_t *out, size_t n) { rand.u64_fill(1000003, out, n); });
+    bench_fill<double>("f52_fill", N, [&](double *out, size_t n) { rand.f52_fill(out, n); });
+    bench_fill<double>("f53_fill", N, [&](double *out, size_t n) { rand.f53_fill(out, n); });
+    bench_fill<float>("f23_fill", N, [&](float *out, size_t n) { rand.f23_fill(out, n); });
+    bench_fill<float>("f24_fill", N, [&](float *out, size_t n) { rand.f24_fill(out, n); });
+    bench_fill<double>("exp_fill", N, [&](double *out, size_t n) { rand.exp_fill(out, n); });
+    bench_fill<double>("normal_fill", N, [&](double *out, size_t n) { rand.normal_fill(out, n); });
+
+    if(selected("StreamFileWriter::Record") || selected("ReplayRandom")) {
+        const char *path = "bench_random.stream";
+        double ns = time_ns(N, [&](size_t m) {
+            StreamFileWriter writer;
+            writer.Open(path, stream_file_info(rand));
+            writer.Record(rand, m);
+            writer.Close();
+        });
+        report("StreamFileWriter::Record", ns, sizeof(uint64_t));
+        StreamFileReader reader;
+        if(reader.Open(path)) {
+            // the warm up and repeats together draw less than the recording
+            ReplayRandom replay = reader.Replay();
+            bench<uint64_t>("ReplayRandom::bits", reader.size() / 8, [&]() { return replay.bits(); });
+            replay.Seed({});
+            bench_fill<double>("ReplayRandom::exp_fill", reader.size() / 8,
+                               [&](double *out, size_t n) { replay.exp_fill(out, n); });
+        }
+        std::remove(path);
+    }
+
+    for(size_t size : {size_t{16}, size_t{1} << 10, size_t{1} << 16, size_t{1} << 20, size_t{1} << 24}) {
+        std::string suffix = "/" + std::to_string(size);
+        // only build the tables if one of their benchmarks is selected
+        bool any = false;
+        for(const char *name : {"AliasTable::Get", "AliasTable::Sample", "PackedAliasTable::Get",
+                                "CompactAliasTable::Get", "CompactAliasTable::Sample"}) {
+            any |= selected(name + suffix);
+        }
+        if(!any) {
+            continue;
+        }
+        std::vector<double> weights(size);
+        for(auto &&w : weights) {
+            w = rand.exp();
+        }
+        AliasTable table(weights);
+        PackedAliasTable packed(weights);
+        CompactAliasTable compact(weights);
+        bench<uint32_t>("AliasTable::Get" + suffix, N, [&]() { return table(rand.bits()); });
+        bench<uint32_t>("PackedAliasTable::Get" + suffix, N, [&]() { return packed(rand.bits()); });
+        bench<uint32_t>("CompactAliasTable::Get" + suffix, N, [&]() { return compact(rand.bits()); });
+        bench_fill<uint32_t>("AliasTable::Sample" + suffix, N,
+                             [&](uint32_t *out, size_t n) { table.Sample(rand, out, n); });
+        bench_fill<uint32_t>("CompactAliasTable::Sample" + suffix, N,
+                             [&](uint32_t *out, size_t n) { compact.Sample(rand, out, n); });
+    }
+
+    {
+        constexpr FixedAliasTable<4> nucleotides({0.3, 0.2, 0.2, 0.3});
+        bench<uint32_t>("FixedAliasTable<4>::Get", N, [&]() { return nucleotides(rand.bits()); });
+        std::array<double, 61> codons;
+        for(auto &&w : codons) {
+            w = rand.exp();
+        }
+        FixedAliasTable<61> table(codons);
+        bench<uint32_t>("FixedAliasTable<61>::Get", N, [&]() { return table(rand.bits()); });
+        bench_fill<uint32_t>("FixedAliasTable<61>::Sample", N,
+                             [&](uint32_t *out, size_t n) { table.Sample(rand, out, n); });
+    }
+
+    // time per weight offered to a reservoir of 100 items
+    if(selected("WeightedReservoir/100")) {
+        std::vector<double> weights(size_t{1} << 16);
+        for(auto &&w : weights) {
+            w = rand.exp();
+        }
+        double ns = time_ns(N, [&](size_t m) {
+            WeightedReservoir reservoir(100);
+            for(size_t i = 0; i < m; i += weights.size()) {
+                reservoir.Push(rand, weights.data(), std::min(weights.size(), m - i));
+            }
+            do_not_optimize(reservoir.count());
+        });
+        report("WeightedReservoir/100", ns, sizeof(double));
+    }
+
+    bench<uint64_t>("Discard/2^20", 1 << 20, [&]() {
+        rand.Discard(size_t{1} << 20);
+        return rand.GetSeed()[0];
+    });
+    bench<uint64_t>("Seed(uint32_t)", 1 << 20, [&, s = 0u]() mutable {
+        rand.Seed(s++);
+        return rand.GetSeed()[0];
+    });
+    bench<uint64_t>("Seed(SeedSeq256)", 1 << 20, [&, s = 0u]() mutable {
+        rand.Seed(SeedSeq256({s++, 1u, 2u, 3u}));
+        return rand.GetSeed()[0];
+    });
+    {
+        SeedSeq256 master({1u, 2u});
+        std::vector<uint64_t> ids(4096);
+        std::iota(ids.begin(), ids.end(), 0);
+        bench<Random::seed_type>("SeedSeq::Spawn", 1 << 20, [&, id = uint64_t{0}]() mutable {
+            Random::seed_type seed;
+            master.Spawn(id++).Generate(seed.begin(), seed.end());
+            return seed;
+        });
+        bench_fill<Random::seed_type>("SeedSeq::GenerateBatch", 1 << 20, [&](Random::seed_type *out, size_t n) {
+            ids[0] += 1;
+            master.GenerateBatch(ids.data(), n, out);
+        });
+    }
+    bench<uint64_t>("Seed(auto_seed_seq)", 1 << 20, [&]() {
+        rand.Seed(auto_seed_seq());
+        return rand.GetSeed()[0];
+    });
+    bench<uint64_t>("Seed(auto_seed_seq_full)", 1 << 16, [&]() {
+        rand.Seed(auto_seed_seq_full());
+        return rand.GetSeed()[0];
+    });
+
+    unsigned int max_threads = std::max(1U, std::thread::hardware_concurrency());
+    for(unsigned int t = 1; t <= max_threads; t *= 2) {
+        bench_threads(t, N);
+    }
+    if((max_threads & (max_threads - 1)) != 0) {
+        bench_threads(max_threads, N);
+    }
+
+    std::string fill_name = "fill(F52Sampler)/threads:" + std::to_string(max_threads);
+    if(selected(fill_name)) {
+        std::vector<double> out(N);
+        ThreadExecutor exec(max_threads);
+        double ns =
+            time_ns(N, [&](size_t m) { fill(exec, out.begin(), out.begin() + m, F52Sampler{}, SeedSeq256({1u})); });
+        report(fill_name, ns, sizeof(double));
+    }
+
+    // build with -DRACUTILS_RANDOM_STATS to see how often slow paths were taken
+    if(Stats::ENABLED) {
+        printf("\n%s", stats().Report().c_str());
+    }
+    return 0;
+}
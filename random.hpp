@@ -24,20 +24,40 @@ SOFTWARE.
 #ifndef RACUTILS_RANDOM_HPP
 #define RACUTILS_RANDOM_HPP
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cfloat>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <deque>
+#include <iterator>
 #include <limits>
+#include <new>
 #include <numeric>
+#include <stdexcept>
 #include <type_traits>
 #include <vector>
 
+// Define RACUTILS_RANDOM_EXECUTION to let fill take std::execution policies.
+// <execution> is slow to parse, so it is only included then. Like the other
+// RACUTILS_RANDOM_ macros, define it in all translation units or in none.
+#if defined(RACUTILS_RANDOM_EXECUTION)
+#include <execution>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 #if defined(_WIN64) || defined(_WIN32)
 #include <process.h>
 #else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #endif
 
@@ -46,11 +66,16 @@ SOFTWARE.
 #include <string>
 #include <thread>
 
+#if defined(RACUTILS_RANDOM_STATS)
+#include <mutex>
+#endif
+
 namespace racutils::random {
 
 template <size_t count>
 class SeedSeq;
-class Random;
+template <typename Engine>
+class BasicRandom;
 
 namespace details {
 
@@ -91,10 +116,39 @@ class Lehmer64Fast {
 
     void Advance() { state_ *= MCG_MULT; }
 
-    void Discard(size_t count) {
-        for(size_t k = 0; k < count; ++k) {
-            Advance();
+    // advance the state by count steps in O(log count) time
+    void Discard(size_t count) { state_ *= JumpMultiplier(count); }
+
+    // returns a copy of the engine advanced by count steps
+    Lehmer64Fast Jump(size_t count) const {
+        Lehmer64Fast engine{*this};
+        engine.Discard(count);
+        return engine;
+    }
+
+    // returns a copy of the engine advanced by k*(2^64+STREAM_OFFSET) steps
+    // The period is 2^126, so there are 2^61 streams of length at least 2^64.
+    // A distance of exactly 2^64 would be a poor choice: MCG_MULT^(2^64) is 1
+    // mod 2^66, so the streams would be nearly linear in k at every position.
+    // The odd offset makes the stream multiplier a full-period multiplier.
+    Lehmer64Fast Stream(uint64_t k) const {
+        Lehmer64Fast engine{*this};
+        engine.state_ *= Power(StreamMultiplier(), k);
+        return engine;
+    }
+
+    // MCG_MULT^count mod 2^128
+    static state_type JumpMultiplier(size_t count) { return Power(MCG_MULT, count); }
+
+    static constexpr uint64_t STREAM_OFFSET = 0x9e3779b97f4a7c15ULL;
+
+    // MCG_MULT^(2^64+STREAM_OFFSET) mod 2^128
+    static state_type StreamMultiplier() {
+        state_type mult = MCG_MULT;
+        for(int i = 0; i < 64; ++i) {
+            mult *= mult;
         }
+        return mult * JumpMultiplier(STREAM_OFFSET);
     }
 
     state_type GetState() const { return state_; }
@@ -104,11 +158,24 @@ class Lehmer64Fast {
         return seed;
     }
 
+    // identifies the engine in checkpoints, "L64F"
+    static constexpr uint32_t ENGINE_ID = 0x4634364c;
+    // state as 64-bit words, low word first
+    static constexpr size_t STATE_WORDS = 2;
+    void GetStateWords(uint64_t *w) const {
+        w[0] = static_cast<uint64_t>(state_);
+        w[1] = static_cast<uint64_t>(state_ >> 64);
+    }
+    void SetStateWords(const uint64_t *w) { SetState((static_cast<state_type>(w[1]) << 64) | w[0]); }
+
     result_type operator()() {
         Advance();
         return static_cast<result_type>(state_ >> (STYPE_BITS - RTYPE_BITS));
     }
 
+    // fill [out, out+n) with the next n values of the stream
+    void Fill(result_type *out, size_t n);
+
     bool operator==(const Lehmer64Fast &rhs) { return (state_ == rhs.state_); }
 
     bool operator!=(const Lehmer64Fast &rhs) { return !operator==(rhs); }
@@ -118,344 +185,3791 @@ class Lehmer64Fast {
         // state must be odd.
         state_ = state | 1;
     }
+
+    // mult^count mod 2^128 calculated by square-and-multiply
+    static state_type Power(state_type mult, uint64_t count) {
+        state_type result = 1;
+        for(; count > 0; count >>= 1) {
+            if(count & 1) {
+                result *= mult;
+            }
+            mult *= mult;
+        }
+        return result;
+    }
 };
 
-using RandomEngine = Lehmer64Fast;
+// Lehmer64xN runs N interleaved copies of a Lehmer64Fast stream.
+// Lane i holds position i of the stream and each lane advances N positions
+// at a time. This breaks the serial dependency chain of the 128-bit
+// multiplication while producing exactly the same values as Lehmer64Fast.
+template <size_t N>
+class Lehmer64xN {
+   public:
+    using result_type = Lehmer64Fast::result_type;
+    using state_type = Lehmer64Fast::state_type;
 
-inline int64_t random_i63(uint64_t u) { return u >> 1; }
-inline uint32_t random_u32(uint64_t u) { return u >> 32; }
-inline int32_t random_i31(uint64_t u) { return u >> 33; }
+    static_assert(N > 0, "Lehmer64xN requires at least one lane.");
 
-// uniformly distributed between [0,range)
-// Algorithm 5 from Lemire (2018) https://arxiv.org/pdf/1805.10941.pdf
-// Modified by M.E. O'Neill (2018) https://www.pcg-random.org/posts/bounded-rands.html
-template <typename callback>
-uint64_t random_u64_range(uint64_t range, callback &get) {
-    uint64_t x = get();
-    __uint128_t m = static_cast<__uint128_t>(x) * static_cast<__uint128_t>(range);
-    auto l = static_cast<uint64_t>(m);
-    if(l < range) {
-        // Calculate {uint64_t t = -range % range} avoiding divisions
-        // as much as possible.
-        uint64_t t = -range;
-        if(t >= range) {
-            t -= range;
-            if(t >= range) {
-                t %= range;
+   private:
+    std::array<state_type, N> lanes_;
+    state_type mult_;
+    static constexpr unsigned int STYPE_BITS = 8 * sizeof(state_type);
+    static constexpr unsigned int RTYPE_BITS = 8 * sizeof(result_type);
+
+   public:
+    explicit Lehmer64xN(const Lehmer64Fast &engine) : mult_{Lehmer64Fast::JumpMultiplier(N)} {
+        state_type state = engine.GetState();
+        const state_type mult = Lehmer64Fast::JumpMultiplier(1);
+        for(auto &&lane : lanes_) {
+            state *= mult;
+            lane = state;
+        }
+    }
+
+    // fill [out, out+n) with the next n values of the stream
+    void Fill(result_type *out, size_t n) {
+        // work on local copies so that stores to out cannot alias the lanes
+        std::array<state_type, N> lanes = lanes_;
+        const state_type mult = mult_;
+        size_t k = 0;
+        for(; k + N <= n; k += N) {
+            for(size_t i = 0; i < N; ++i) {
+                out[k + i] = static_cast<result_type>(lanes[i] >> (STYPE_BITS - RTYPE_BITS));
+                lanes[i] *= mult;
             }
         }
-        while(l < t) {
-            x = get();
-            m = static_cast<__uint128_t>(x) * static_cast<__uint128_t>(range);
-            l = static_cast<uint64_t>(m);
+        lanes_ = lanes;
+        // finish with a partial step and rotate the lanes so that lane 0
+        // holds the next position of the stream
+        size_t r = n - k;
+        if(r == 0) {
+            return;
         }
+        for(size_t i = 0; i < r; ++i) {
+            out[k + i] = static_cast<result_type>(lanes_[i] >> (STYPE_BITS - RTYPE_BITS));
+            lanes_[i] *= mult_;
+        }
+        std::rotate(lanes_.begin(), lanes_.begin() + r, lanes_.end());
     }
-    return m >> 64;
-}
+};
 
-inline std::pair<uint32_t, uint32_t> random_u32_pair(uint64_t u) { return {u, u >> 32}; }
+using Lehmer64x4 = Lehmer64xN<4>;
+using Lehmer64x8 = Lehmer64xN<8>;
 
-inline double random_f53(uint64_t u) {
-    auto n = static_cast<int64_t>(u >> 11);
-    return n / 9007199254740992.0;
+inline void Lehmer64Fast::Fill(result_type *out, size_t n) {
+    Lehmer64x4 lanes{*this};
+    lanes.Fill(out, n);
+    Discard(n);
 }
 
-inline double random_f52(uint64_t u) {
-    auto n = 1 | static_cast<int64_t>(u >> 11);
-    return n / 9007199254740992.0;
-}
+/*
+xoshiro256** 1.0
+Written in 2018 by David Blackman and Sebastiano Vigna (vigna@acm.org)
+http://xoshiro.di.unimi.it/
+This is a header-only version of contrib/xoshiro256starstar.c
+*/
 
+// Polynomials over GF(2) of degree < 256 used to jump xoshiro256 ahead.
+// Bit b of word i is the coefficient of x^(64*i+b).
+namespace xoshiro {
+using poly_type = std::array<uint64_t, 4>;
 
-inline double random_exp_inv(double f) { return -log(f); }
+// characteristic polynomial of the xoshiro256 linear engine without x^256
+constexpr poly_type CHAR_POLY = {0x9d116f2bb0f0f001ULL, 0x0280002bcefd1a5eULL, 0x04b4edcf26259f85ULL,
+                                 0x0003c03c3f3ecb19ULL};
+// x^(2^128) mod CHAR_POLY
+constexpr poly_type JUMP = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL,
+                            0x39abdc4529b1661cULL};
+// x^(2^192) mod CHAR_POLY
+constexpr poly_type LONG_JUMP = {0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL,
+                                 0x39109bb02acbe635ULL};
+
+// multiply a by x modulo CHAR_POLY
+inline poly_type poly_mulx(poly_type a) {
+    uint64_t carry = a[3] >> 63;
+    a[3] = (a[3] << 1) | (a[2] >> 63);
+    a[2] = (a[2] << 1) | (a[1] >> 63);
+    a[1] = (a[1] << 1) | (a[0] >> 63);
+    a[0] = (a[0] << 1);
+    if(carry != 0) {
+        for(size_t i = 0; i < a.size(); ++i) {
+            a[i] ^= CHAR_POLY[i];
+        }
+    }
+    return a;
+}
 
-extern const std::array<int64_t, 256> ek;
-extern const std::array<double, 256> ew;
-extern const std::array<double, 256> ef;
+// multiply a by b modulo CHAR_POLY
+inline poly_type poly_mulmod(poly_type a, const poly_type &b) {
+    poly_type r = {0, 0, 0, 0};
+    for(auto &&w : b) {
+        for(int k = 0; k < 64; ++k) {
+            if(w & (UINT64_C(1) << k)) {
+                for(size_t i = 0; i < r.size(); ++i) {
+                    r[i] ^= a[i];
+                }
+            }
+            a = poly_mulx(a);
+        }
+    }
+    return r;
+}
 
-template <typename callback>
-double random_exp_zig_internal(int64_t a, int b, callback &get) {
-    constexpr double r = 7.69711747013104972;
-    do {
-        if(b == 0) {
-            return r + random_exp_inv(random_f52(get()));
+// x^count mod CHAR_POLY by square-and-multiply
+inline poly_type poly_powx(size_t count) {
+    poly_type r = {1, 0, 0, 0};
+    int k = std::numeric_limits<size_t>::digits - 1;
+    // skip leading zeros
+    for(; k >= 0 && ((count >> k) & 1) == 0; --k) {
+        /*noop*/;
+    }
+    for(; k >= 0; --k) {
+        r = poly_mulmod(r, r);
+        if((count >> k) & 1) {
+            r = poly_mulx(r);
         }
-        double x = a * ew[b];
-        if(ef[b - 1] + random_f52(get()) * (ef[b] - ef[b - 1]) < exp(-x)) {
-            return x;
+    }
+    return r;
+}
+
+// JUMP^(2^i) mod CHAR_POLY, computed once
+inline const std::array<poly_type, 64> &jump_powers() {
+    static const std::array<poly_type, 64> table = [] {
+        std::array<poly_type, 64> t;
+        t[0] = JUMP;
+        for(size_t i = 1; i < t.size(); ++i) {
+            t[i] = poly_mulmod(t[i - 1], t[i - 1]);
         }
-        a = random_i63(get());
-        b = static_cast<int>(a & 255);
-    } while(a > ek[b]);
-    return a * ew[b];
+        return t;
+    }();
+    return table;
 }
 
-template <typename callback>
-inline double random_exp_zig(callback &get) {
-    int64_t a = random_i63(get());
-    auto b = static_cast<int>(a & 255);
-    if(a <= ek[b]) {
-        return a * ew[b];
+// JUMP^count mod CHAR_POLY, i.e. x^(count*2^128)
+inline poly_type poly_jump(uint64_t count) {
+    const auto &powers = jump_powers();
+    poly_type r = {1, 0, 0, 0};
+    for(size_t i = 0; count > 0; count >>= 1, ++i) {
+        if(count & 1) {
+            r = poly_mulmod(r, powers[i]);
+        }
     }
-    return random_exp_zig_internal(a, b, get);
+    return r;
 }
+}  // namespace xoshiro
 
-}  // namespace details
+class Xoshiro256StarStar {
+   public:
+    using result_type = uint64_t;
+    using state_type = std::array<uint64_t, 4>;
+    using seed_type = std::array<uint32_t, sizeof(state_type) / sizeof(uint32_t)>;
 
-// code sanity check
-static_assert(std::is_same<uint64_t, details::RandomEngine::result_type>::value,
-              "The result type of RandomEngine is not a uint64_t.");
+   private:
+    state_type state_;
+    // state produced by splitmix64 seeded with 0x9f57c403d06c42fc
+    static constexpr state_type DEFAULT_STATE = {0xaaff40bc666ebe3dULL, 0x42746fcf23f65403ULL, 0x060ed5c6db2a80fcULL,
+                                                 0x49f50804ce3efa80ULL};
+    // below this many steps, Discard steps the generator instead of using a polynomial
+    static constexpr size_t DISCARD_CUTOFF = 1024;
 
-class Random : public details::RandomEngine {
    public:
-    using engine_type = details::RandomEngine;
-    // import constructor
-    using engine_type::engine_type;
-    // import seed_type
-    using seed_type = engine_type::seed_type;
+    static constexpr result_type min() { return static_cast<result_type>(0); }
+    static constexpr result_type max() { return static_cast<result_type>(~static_cast<result_type>(0)); }
 
-    uint64_t bits();
-    uint64_t bits(int b);
+    explicit Xoshiro256StarStar(state_type state = DEFAULT_STATE) { SetState(state); }
+    explicit Xoshiro256StarStar(seed_type seed) { Seed(seed); }
 
-    uint64_t u64();
-    uint64_t u64(uint64_t range);
+    void Seed(state_type state) { SetState(state); }
 
-    uint32_t u32();
-    std::pair<uint32_t, uint32_t> u32_pair();
+    void Seed(seed_type seed) {
+        state_type state;
+        std::memcpy(&state, &seed, sizeof(seed));
+        Seed(state);
+    }
 
-    double f52();
-    double f53();
+    void Advance() {
+        const uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+    }
 
-    double exp(double mean = 1.0);
+    // advance the state by count steps in O(log count) time
+    void Discard(size_t count) {
+        if(count < DISCARD_CUTOFF) {
+            for(size_t k = 0; k < count; ++k) {
+                Advance();
+            }
+            return;
+        }
+        ApplyPolynomial(xoshiro::poly_powx(count));
+    }
 
-    template <size_t count>
-    void Seed(const SeedSeq<count> &ss);
-    void Seed(const uint32_t s);
-    using engine_type::Seed;
-};
+    // returns a copy of the engine advanced by count steps
+    Xoshiro256StarStar Jump(size_t count) const {
+        Xoshiro256StarStar engine{*this};
+        engine.Discard(count);
+        return engine;
+    }
 
-// uniformly distributed between [0,2^64)
-inline uint64_t Random::bits() { return details::RandomEngine::operator()(); }
-// uniformly distributed between [0,2^b)
-inline uint64_t Random::bits(int b) { return bits() >> (64 - b); }
+    // returns a copy of the engine advanced by 2^128 steps
+    Xoshiro256StarStar Jump() const {
+        Xoshiro256StarStar engine{*this};
+        engine.ApplyPolynomial(xoshiro::JUMP);
+        return engine;
+    }
 
-// uniformly distributed between [0,2^64)
-inline uint64_t Random::u64() { return bits(); }
+    // returns a copy of the engine advanced by 2^192 steps
+    Xoshiro256StarStar LongJump() const {
+        Xoshiro256StarStar engine{*this};
+        engine.ApplyPolynomial(xoshiro::LONG_JUMP);
+        return engine;
+    }
 
-// uniformly distributed between [0,range)
-inline uint64_t Random::u64(uint64_t range) { return details::random_u64_range(range, *this); }
+    // returns a copy of the engine advanced by k*2^128 steps
+    Xoshiro256StarStar Stream(uint64_t k) const {
+        Xoshiro256StarStar engine{*this};
+        engine.ApplyPolynomial(xoshiro::poly_jump(k));
+        return engine;
+    }
 
-// uniformly distributed between [0,2^32)
-inline uint32_t Random::u32() { return details::random_u32(bits()); }
+    state_type GetState() const { return state_; }
+    seed_type GetSeed() const {
+        seed_type seed;
+        std::memcpy(&seed, &state_, sizeof(seed));
+        return seed;
+    }
 
-// uniformly distributed pair between [0,2^32)
-inline std::pair<uint32_t, uint32_t> Random::u32_pair() { return details::random_u32_pair(bits()); }
+    // identifies the engine in checkpoints, "X256"
+    static constexpr uint32_t ENGINE_ID = 0x36353258;
+    static constexpr size_t STATE_WORDS = 4;
+    void GetStateWords(uint64_t *w) const { std::copy(state_.begin(), state_.end(), w); }
+    void SetStateWords(const uint64_t *w) { SetState(state_type{w[0], w[1], w[2], w[3]}); }
 
-// uniformly distributed between (0,1.0)
-inline double Random::f52() { return details::random_f52(bits()); }
+    result_type operator()() {
+        const result_type result = rotl(state_[1] * 5, 7) * 9;
+        Advance();
+        return result;
+    }
 
-// uniformly distributed between [0,1.0)
-inline double Random::f53() { return details::random_f53(bits()); }
+    // fill [out, out+n) with the next n values of the stream
+    void Fill(result_type *out, size_t n) {
+        Xoshiro256StarStar engine{*this};
+        for(size_t k = 0; k < n; ++k) {
+            out[k] = engine();
+        }
+        state_ = engine.state_;
+    }
 
-// exponential random value with specified mean. mean=1.0/rate
-inline double Random::exp(double mean) { return details::random_exp_zig(*this) * mean; }
+    bool operator==(const Xoshiro256StarStar &rhs) { return (state_ == rhs.state_); }
 
-// Think about using https://gist.github.com/imneme/540829265469e673d045
-// https://www.pcg-random.org/posts/simple-portable-cpp-seed-entropy.html
-// https://www.pcg-random.org/posts/cpps-random_device.html
+    bool operator!=(const Xoshiro256StarStar &rhs) { return !operator==(rhs); }
 
-namespace details {
-// Multilinear hash (https://arxiv.org/pdf/1202.4961.pdf)
-// Hash is based on a sequence of 64-bit numbers generated by Weyl sequence
-// Multilinear hash is (m_0 + sum(m_i*u_i) mod 2^64) / 2^32
-// m = buffer of 64-bit unsigned random values
-// u = 32-bit input values that are being hashed
-template <uint64_t INC, uint64_t INIT>
-struct hash_impl_t {
-    template <typename In1, typename In2, typename Out1, typename Out2>
-    void operator()(In1 it1, In2 it2, Out1 itA, Out2 itB) {
-        uint64_t w = INIT;
-        auto next_num = [&w]() {
-            w += INC;
-            return w;
-        };
+   private:
+    static constexpr uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
 
-        for(auto out = itA; out != itB; ++out) {
-            // hash input
-            uint64_t sum = next_num();
-            for(auto it = it1; it != it2; ++it) {
-                uint32_t u = *it;
-                sum += next_num() * u;
+    void SetState(state_type state) {
+        // state must not be everywhere zero.
+        if(state == state_type{0, 0, 0, 0}) {
+            state = DEFAULT_STATE;
+        }
+        state_ = state;
+    }
+
+    // replace the state with poly(T) applied to the state, where T is the
+    // transition of the linear engine
+    void ApplyPolynomial(const xoshiro::poly_type &poly) {
+        state_type s = {0, 0, 0, 0};
+        for(auto &&w : poly) {
+            for(int b = 0; b < 64; ++b) {
+                if(w & (UINT64_C(1) << b)) {
+                    for(size_t i = 0; i < s.size(); ++i) {
+                        s[i] ^= state_[i];
+                    }
+                }
+                Advance();
             }
-            // If input ends in a zero, the hash is not unique.
-            // Add a final value to ensure that this doesn't happen.
-            sum += next_num() * 1;
-            // final value
-            *out = static_cast<uint32_t>(sum >> 32);
         }
+        state_ = s;
     }
 };
 
-using hash_implA = hash_impl_t<0x9e3779b97f4a7c15ULL, 0x3423da0b87484307ULL>;
-using hash_implB = hash_impl_t<0x9e3779b97f4a7c15ULL, 0xdf8b06c40fa44478ULL>;
-}  // namespace details
+/*
+Philox2x64-10 counter-based PRNG
+Salmon, Moraes, Dror, and Shaw (2011) Parallel random numbers: as easy as 1, 2, 3.
+https://www.thesalmons.org/john/random123/papers/random123sc11.pdf
+*/
 
-// SeedSeq is a finite entropy seed sequence.
-// Inspiration: https://www.pcg-random.org/posts/developing-a-seed_seq-alternative.html
-template <size_t count>
-class SeedSeq {
+// Philox2x64 is a stateless generator: draw n of stream s is a bijective
+// function of the 128-bit counter {n/2, s} under a 64-bit key. Any draw can be
+// computed directly with At(s, n), and Discard and Stream are O(1).
+// Streams hold 2^64 draws each, so the engine is one sequence of 2^128 draws.
+class Philox2x64 {
    public:
-    using result_type = uint32_t;
+    using result_type = uint64_t;
+    // {key, stream, counter}
+    using state_type = std::array<uint64_t, 3>;
+    using seed_type = std::array<uint32_t, 2>;
+    using block_type = std::array<uint64_t, 2>;
 
    private:
-    std::array<result_type, count> state_;
+    uint64_t key_{0};
+    uint64_t stream_{0};
+    uint64_t counter_{0};
+    // second half of the current block, valid when counter_ is odd
+    uint64_t next_{0};
+
+    static constexpr uint64_t PHILOX_M = 0xD2B74407B1CE6E93ULL;
+    static constexpr uint64_t PHILOX_W = 0x9E3779B97F4A7C15ULL;
+    static constexpr int ROUNDS = 10;
 
    public:
-    template <typename It1, typename It2>
-    SeedSeq(It1 begin, It2 end) {
-        Seed(begin, end);
-    }
+    static constexpr result_type min() { return static_cast<result_type>(0); }
+    static constexpr result_type max() { return static_cast<result_type>(~static_cast<result_type>(0)); }
 
-    template <typename T>
-    SeedSeq(std::initializer_list<T> init) {
-        Seed(init.begin(), init.end());
-    }
+    explicit Philox2x64(state_type state = state_type{0x9f57c403d06c42fcULL, 0, 0}) { SetState(state); }
+    explicit Philox2x64(seed_type seed) { Seed(seed); }
 
-    // Generates an internal state based on provided seeds
-    template <typename It1, typename It2>
-    void Seed(It1 begin, It2 end) {
-        details::hash_implA hash;
-        hash(begin, end, state_.begin(), state_.end());
+    void Seed(state_type state) { SetState(state); }
+
+    // sets the key and moves to the start of stream 0
+    void Seed(seed_type seed) {
+        uint64_t key;
+        std::memcpy(&key, &seed, sizeof(seed));
+        Seed(state_type{key, 0, 0});
     }
 
-    // Generates an external state based on the internal state
-    template <typename It1, typename It2>
-    void Generate(It1 begin, It2 end) const {
-        details::hash_implB hash;
-        hash(state_.begin(), state_.end(), begin, end);
+    // the Philox2x64-10 bijection of ctr under key
+    static block_type Block(block_type ctr, uint64_t key) {
+        for(int r = 0; r < ROUNDS; ++r) {
+            __uint128_t prod = static_cast<__uint128_t>(PHILOX_M) * ctr[0];
+            auto hi = static_cast<uint64_t>(prod >> 64);
+            auto lo = static_cast<uint64_t>(prod);
+            ctr = {hi ^ key ^ ctr[1], lo};
+            key += PHILOX_W;
+        }
+        return ctr;
     }
-};
 
-using SeedSeq256 = SeedSeq<8>;
+    // returns draw counter of stream without changing the engine
+    result_type At(uint64_t stream, uint64_t counter) const {
+        return Block({counter >> 1, stream}, key_)[counter & 1];
+    }
 
-inline void Random::Seed(uint32_t s) {
-    SeedSeq256 ss({s});
-    Seed(ss);
-}
+    // moves to draw counter of stream
+    void Seek(uint64_t stream, uint64_t counter) { SetState(state_type{key_, stream, counter}); }
 
-template <size_t count>
-inline void Random::Seed(const SeedSeq<count> &ss) {
-    seed_type seed;
-    ss.Generate(seed.begin(), seed.end());
-    Seed(seed);
-}
+    void Advance() { Discard(1); }
 
-namespace details {
-inline std::string base58_encode(uint32_t u) {
-    const char *base58_alphabet = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+    // advance the state by count steps in O(1) time
+    void Discard(size_t count) {
+        uint64_t counter = counter_ + count;
+        SetState(state_type{key_, (counter < counter_) ? stream_ + 1 : stream_, counter});
+    }
 
-    std::string buffer(6, base58_alphabet[0]);
-    for(int i = 0; i < 6 && u != 0; ++i) {
-        buffer[5 - i] = base58_alphabet[u % 58];
-        u = u / 58;
+    // returns a copy of the engine advanced by count steps
+    Philox2x64 Jump(size_t count) const {
+        Philox2x64 engine{*this};
+        engine.Discard(count);
+        return engine;
     }
-    return buffer;
-}
-}  // namespace details
 
-template <size_t COUNT>
-std::string encode_seed(const std::array<uint32_t, COUNT> &seed) {
-    if(seed.empty()) {
-        return {};
+    // returns a copy of the engine advanced by k*2^64 steps
+    Philox2x64 Stream(uint64_t k) const {
+        Philox2x64 engine{*this};
+        engine.SetState(state_type{key_, stream_ + k, counter_});
+        return engine;
     }
-    std::string str = details::base58_encode(seed[0]);
-    for(int i=1;i<seed.size(); ++i) {
-        str += "-";
-        str += details::base58_encode(seed[i]);
+
+    state_type GetState() const { return {key_, stream_, counter_}; }
+    seed_type GetSeed() const {
+        seed_type seed;
+        std::memcpy(&seed, &key_, sizeof(seed));
+        return seed;
     }
-    return str;
-}
 
-namespace details {
-static constexpr uint32_t fnv(uint32_t hash, const char *pos) {
-    return *pos == '\0' ? hash : fnv((hash * 16777619U) ^ *pos, pos + 1);
-}
+    // identifies the engine in checkpoints, "P2X4"
+    static constexpr uint32_t ENGINE_ID = 0x34583250;
+    // key, stream, counter, and the cached half block
+    static constexpr size_t STATE_WORDS = 4;
+    void GetStateWords(uint64_t *w) const {
+        w[0] = key_;
+        w[1] = stream_;
+        w[2] = counter_;
+        w[3] = next_;
+    }
+    void SetStateWords(const uint64_t *w) { SetState(state_type{w[0], w[1], w[2]}); }
 
-template <typename T>
-static uint64_t hash(T &&value) {
+    result_type operator()() {
+        result_type result;
+        if(counter_ & 1) {
+            result = next_;
+        } else {
+            block_type b = Block({counter_ >> 1, stream_}, key_);
+            result = b[0];
+            next_ = b[1];
+        }
+        if(++counter_ == 0) {
+            ++stream_;
+        }
+        return result;
+    }
+
+    // fill [out, out+n) with the next n values of the stream
+    void Fill(result_type *out, size_t n) {
+        for(size_t k = 0; k < n; ++k) {
+            out[k] = operator()();
+        }
+    }
+
+    bool operator==(const Philox2x64 &rhs) { return GetState() == rhs.GetState(); }
+
+    bool operator!=(const Philox2x64 &rhs) { return !operator==(rhs); }
+
+   private:
+    void SetState(state_type state) {
+        key_ = state[0];
+        stream_ = state[1];
+        counter_ = state[2];
+        if(counter_ & 1) {
+            next_ = Block({counter_ >> 1, stream_}, key_)[1];
+        }
+    }
+};
+
+// Select an engine for Random. Lehmer64Fast is the default. Define
+// RACUTILS_RANDOM_USE_XOSHIRO to use xoshiro256** instead, e.g. on platforms
+// where 128-bit multiplication is slow.
+#if defined(RACUTILS_RANDOM_USE_XOSHIRO)
+using RandomEngine = Xoshiro256StarStar;
+#else
+using RandomEngine = Lehmer64Fast;
+#endif
+}  // namespace details
+
+// Statistics about engine draws and the slow paths of samplers. Define
+// RACUTILS_RANDOM_STATS to collect them. Each thread counts into its own
+// counters with relaxed atomics, and stats() sums all threads. Without the
+// macro nothing is counted and stats() returns zeros.
+// The draws of the composite samplers are the ENGINE_DRAWS made during the
+// call, so they are only exact for a BasicRandom. Through BasicBufferedRandom
+// they land on the calls that refill the buffer.
+enum class Stat : size_t {
+    // values produced by engines through BasicRandom
+    ENGINE_DRAWS,
+    // exponential ziggurat: samples, uniforms used, slow path, b == 0 tail
+    EXP_CALLS,
+    EXP_DRAWS,
+    EXP_SLOW,
+    EXP_TAIL,
+    // normal ziggurat: samples, uniforms used, slow path, b == 0 tail
+    NORMAL_CALLS,
+    NORMAL_DRAWS,
+    NORMAL_SLOW,
+    NORMAL_TAIL,
+    // bounded integers: samples, uniforms used, samples that needed a redraw
+    RANGE_CALLS,
+    RANGE_DRAWS,
+    RANGE_SLOW,
+    // rejection samplers: samples, engine draws, rejected proposals
+    POISSON_CALLS,
+    POISSON_DRAWS,
+    POISSON_SLOW,
+    BINOMIAL_CALLS,
+    BINOMIAL_DRAWS,
+    BINOMIAL_SLOW,
+    GAMMA_CALLS,
+    GAMMA_DRAWS,
+    GAMMA_SLOW,
+    // Beta samples and Dirichlet vectors, and their engine draws
+    BETA_CALLS,
+    BETA_DRAWS,
+    DIRICHLET_CALLS,
+    DIRICHLET_DRAWS,
+    // Bernoulli and Geometric samples and their engine draws
+    BERNOULLI_CALLS,
+    BERNOULLI_DRAWS,
+    GEOMETRIC_CALLS,
+    GEOMETRIC_DRAWS,
+    // alias table samples from Sample(rand, out, n) and their engine draws
+    ALIAS_CALLS,
+    ALIAS_DRAWS,
+    // shuffled positions and sample_k outputs, and their engine draws
+    SHUFFLE_CALLS,
+    SHUFFLE_DRAWS,
+    SAMPLE_K_CALLS,
+    SAMPLE_K_DRAWS,
+    // BasicBufferedRandom: requests, buffered words used, buffer refills
+    BUFFERED_CALLS,
+    BUFFERED_DRAWS,
+    BUFFERED_SLOW,
+    COUNT
+};
+
+class Stats {
+   public:
+    static constexpr size_t SIZE = static_cast<size_t>(Stat::COUNT);
+#if defined(RACUTILS_RANDOM_STATS)
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    uint64_t operator[](Stat s) const { return counts_[static_cast<size_t>(s)]; }
+    uint64_t &operator[](Stat s) { return counts_[static_cast<size_t>(s)]; }
+
+    // a/b, or 0 if b is 0; e.g. EXP_DRAWS per EXP_CALLS or EXP_SLOW per EXP_CALLS
+    double Ratio(Stat a, Stat b) const {
+        return (*this)[b] == 0 ? 0.0 : static_cast<double>((*this)[a]) / static_cast<double>((*this)[b]);
+    }
+
+    // one line per sampler with its samples, draws per sample, and slow-path rates
+    std::string Report() const;
+
+   private:
+    std::array<uint64_t, SIZE> counts_{};
+};
+
+#if defined(RACUTILS_RANDOM_STATS)
+namespace details {
+struct ThreadStats;
+
+struct StatsRegistry {
+    std::mutex mutex;
+    std::vector<ThreadStats *> threads;
+    // counts of threads that have exited
+    Stats retired;
+};
+
+inline StatsRegistry &stats_registry() {
+    static StatsRegistry registry;
+    return registry;
+}
+
+// Only the owning thread writes its counters, so an increment is a relaxed
+// load and store rather than a read-modify-write.
+struct ThreadStats {
+    std::array<std::atomic<uint64_t>, Stats::SIZE> counts{};
+
+    ThreadStats() {
+        auto &registry = stats_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.threads.push_back(this);
+    }
+    ~ThreadStats() {
+        auto &registry = stats_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for(size_t i = 0; i < Stats::SIZE; ++i) {
+            registry.retired[static_cast<Stat>(i)] += counts[i].load(std::memory_order_relaxed);
+        }
+        registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), this));
+    }
+    ThreadStats(const ThreadStats &) = delete;
+    ThreadStats &operator=(const ThreadStats &) = delete;
+};
+
+inline ThreadStats &thread_stats() {
+    thread_local ThreadStats stats;
+    return stats;
+}
+
+inline void stat_add(Stat s, uint64_t n) {
+    auto &c = thread_stats().counts[static_cast<size_t>(s)];
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline uint64_t engine_draws() {
+    return thread_stats().counts[static_cast<size_t>(Stat::ENGINE_DRAWS)].load(std::memory_order_relaxed);
+}
+
+// adds the engine draws of the calling thread during its lifetime to a stat
+class DrawScope {
+   public:
+    explicit DrawScope(Stat s) : stat_{s}, start_{engine_draws()} {}
+    ~DrawScope() { stat_add(stat_, engine_draws() - start_); }
+    DrawScope(const DrawScope &) = delete;
+    DrawScope &operator=(const DrawScope &) = delete;
+
+   private:
+    Stat stat_;
+    uint64_t start_;
+};
+}  // namespace details
+
+#define RACUTILS_RANDOM_STAT_ADD(stat, n) ::racutils::random::details::stat_add(::racutils::random::Stat::stat, n)
+#define RACUTILS_RANDOM_STAT_DRAWS(stat) \
+    const ::racutils::random::details::DrawScope racutils_random_draw_scope_(::racutils::random::Stat::stat)
+#else
+#define RACUTILS_RANDOM_STAT_ADD(stat, n) static_cast<void>(0)
+#define RACUTILS_RANDOM_STAT_DRAWS(stat) static_cast<void>(0)
+#endif
+#define RACUTILS_RANDOM_STAT(stat) RACUTILS_RANDOM_STAT_ADD(stat, 1)
+
+// the counts of all threads
+inline Stats stats() {
+    Stats result;
+#if defined(RACUTILS_RANDOM_STATS)
+    auto &registry = details::stats_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    result = registry.retired;
+    for(auto &&t : registry.threads) {
+        for(size_t i = 0; i < Stats::SIZE; ++i) {
+            result[static_cast<Stat>(i)] += t->counts[i].load(std::memory_order_relaxed);
+        }
+    }
+#endif
+    return result;
+}
+
+// Set all counts to zero. Counts made by other threads while this runs may
+// be lost, so call it while samplers are idle.
+inline void reset_stats() {
+#if defined(RACUTILS_RANDOM_STATS)
+    auto &registry = details::stats_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.retired = Stats{};
+    for(auto &&t : registry.threads) {
+        for(auto &&c : t->counts) {
+            c.store(0, std::memory_order_relaxed);
+        }
+    }
+#endif
+}
+
+inline std::string Stats::Report() const {
+    struct Row {
+        const char *name;
+        Stat calls, draws, slow, tail;
+    };
+    const Row rows[] = {
+        {"exp", Stat::EXP_CALLS, Stat::EXP_DRAWS, Stat::EXP_SLOW, Stat::EXP_TAIL},
+        {"normal", Stat::NORMAL_CALLS, Stat::NORMAL_DRAWS, Stat::NORMAL_SLOW, Stat::NORMAL_TAIL},
+        {"u64(range)", Stat::RANGE_CALLS, Stat::RANGE_DRAWS, Stat::RANGE_SLOW, Stat::COUNT},
+        {"poisson", Stat::POISSON_CALLS, Stat::POISSON_DRAWS, Stat::POISSON_SLOW, Stat::COUNT},
+        {"binomial", Stat::BINOMIAL_CALLS, Stat::BINOMIAL_DRAWS, Stat::BINOMIAL_SLOW, Stat::COUNT},
+        {"gamma", Stat::GAMMA_CALLS, Stat::GAMMA_DRAWS, Stat::GAMMA_SLOW, Stat::COUNT},
+        {"beta", Stat::BETA_CALLS, Stat::BETA_DRAWS, Stat::COUNT, Stat::COUNT},
+        {"dirichlet", Stat::DIRICHLET_CALLS, Stat::DIRICHLET_DRAWS, Stat::COUNT, Stat::COUNT},
+        {"bernoulli", Stat::BERNOULLI_CALLS, Stat::BERNOULLI_DRAWS, Stat::COUNT, Stat::COUNT},
+        {"geometric", Stat::GEOMETRIC_CALLS, Stat::GEOMETRIC_DRAWS, Stat::COUNT, Stat::COUNT},
+        {"alias", Stat::ALIAS_CALLS, Stat::ALIAS_DRAWS, Stat::COUNT, Stat::COUNT},
+        {"shuffle", Stat::SHUFFLE_CALLS, Stat::SHUFFLE_DRAWS, Stat::COUNT, Stat::COUNT},
+        {"sample_k", Stat::SAMPLE_K_CALLS, Stat::SAMPLE_K_DRAWS, Stat::COUNT, Stat::COUNT},
+        {"buffered", Stat::BUFFERED_CALLS, Stat::BUFFERED_DRAWS, Stat::BUFFERED_SLOW, Stat::COUNT},
+    };
+    std::string out = "engine draws: " + std::to_string((*this)[Stat::ENGINE_DRAWS]) + "\n";
+    for(auto &&row : rows) {
+        if((*this)[row.calls] == 0) {
+            continue;
+        }
+        out += std::string(row.name) + ": " + std::to_string((*this)[row.calls]) + " samples";
+        if(row.draws != Stat::COUNT) {
+            out += ", " + std::to_string(Ratio(row.draws, row.calls)) + " draws/sample";
+        }
+        if(row.slow != Stat::COUNT) {
+            out += ", slow " + std::to_string(Ratio(row.slow, row.calls));
+        }
+        if(row.tail != Stat::COUNT) {
+            out += ", tail " + std::to_string(Ratio(row.tail, row.calls));
+        }
+        out += "\n";
+    }
+    return out;
+}
+
+namespace details {
+
+inline int64_t random_i63(uint64_t u) { return u >> 1; }
+inline uint32_t random_u32(uint64_t u) { return u >> 32; }
+inline int32_t random_i31(uint64_t u) { return u >> 33; }
+
+// Calculate {uint64_t t = -range % range} avoiding divisions
+// as much as possible. range == 0 has no threshold, and the range functions
+// below return 0 for it. Callers that want all 2^64 values must draw bits
+// directly, as UniformIntDistribution does.
+inline constexpr uint64_t random_u64_threshold(uint64_t range) {
+    if(range == 0) {
+        return 0;
+    }
+    uint64_t t = -range;
+    if(t >= range) {
+        t -= range;
+        if(t >= range) {
+            t %= range;
+        }
+    }
+    return t;
+}
+
+// uniformly distributed between [0,range)
+// Algorithm 5 from Lemire (2018) https://arxiv.org/pdf/1805.10941.pdf
+// Modified by M.E. O'Neill (2018) https://www.pcg-random.org/posts/bounded-rands.html
+template <typename callback>
+uint64_t random_u64_range(uint64_t range, callback &get) {
+    RACUTILS_RANDOM_STAT(RANGE_CALLS);
+    RACUTILS_RANDOM_STAT(RANGE_DRAWS);
+    uint64_t x = get();
+    __uint128_t m = static_cast<__uint128_t>(x) * static_cast<__uint128_t>(range);
+    auto l = static_cast<uint64_t>(m);
+    if(l < range) {
+        uint64_t t = random_u64_threshold(range);
+        RACUTILS_RANDOM_STAT_ADD(RANGE_SLOW, l < t);
+        while(l < t) {
+            RACUTILS_RANDOM_STAT(RANGE_DRAWS);
+            x = get();
+            m = static_cast<__uint128_t>(x) * static_cast<__uint128_t>(range);
+            l = static_cast<uint64_t>(m);
+        }
+    }
+    return m >> 64;
+}
+
+// uniformly distributed between [0,range) using a precomputed threshold t
+template <typename callback>
+uint64_t random_u64_range(uint64_t range, uint64_t t, callback &get) {
+    RACUTILS_RANDOM_STAT(RANGE_CALLS);
+    __uint128_t m = static_cast<__uint128_t>(get()) * static_cast<__uint128_t>(range);
+    RACUTILS_RANDOM_STAT(RANGE_DRAWS);
+    if(static_cast<uint64_t>(m) < t) {
+        RACUTILS_RANDOM_STAT(RANGE_SLOW);
+        do {
+            m = static_cast<__uint128_t>(get()) * static_cast<__uint128_t>(range);
+            RACUTILS_RANDOM_STAT(RANGE_DRAWS);
+        } while(static_cast<uint64_t>(m) < t);
+    }
+    return m >> 64;
+}
+
+// Map u[0..n) into [0,range) with threshold t. Returns the index of the
+// first draw that must be rejected, or n if there is none.
+inline size_t random_u64_range_block(const uint64_t *u, size_t n, uint64_t range, uint64_t t, uint64_t *out) {
+    uint64_t rejected = 0;
+    for(size_t i = 0; i < n; ++i) {
+        __uint128_t m = static_cast<__uint128_t>(u[i]) * static_cast<__uint128_t>(range);
+        out[i] = m >> 64;
+        rejected |= static_cast<uint64_t>(static_cast<uint64_t>(m) < t);
+    }
+    if(rejected == 0) {
+        return n;
+    }
+    size_t i = 0;
+    for(; static_cast<uint64_t>(static_cast<__uint128_t>(u[i]) * range) >= t; ++i) {
+        /*noop*/;
+    }
+    return i;
+}
+
+// Fill [out, out+n) with values in [0,range), producing the same values as
+// calling random_u64_range n times.
+template <typename RNG>
+void random_u64_range_fill(uint64_t range, uint64_t t, uint64_t *out, size_t n, RNG &rand) {
+    constexpr size_t BLOCK_SIZE = 256;
+    std::array<uint64_t, BLOCK_SIZE> u;
+    for(size_t k = 0; k < n; k += BLOCK_SIZE) {
+        size_t len = std::min(BLOCK_SIZE, n - k);
+        rand.fill_u64(u.data(), len);
+        size_t j = random_u64_range_block(u.data(), len, range, t, out + k);
+        // the rest of the block is counted by random_u64_range
+        RACUTILS_RANDOM_STAT_ADD(RANGE_CALLS, j);
+        RACUTILS_RANDOM_STAT_ADD(RANGE_DRAWS, j);
+        if(j == len) {
+            continue;
+        }
+        // finish the block one value at a time, using the buffered draws first
+        size_t next = j;
+        auto get = [&]() { return (next < len) ? u[next++] : rand.bits(); };
+        for(size_t i = j; i < len; ++i) {
+            out[k + i] = random_u64_range(range, t, get);
+        }
+    }
+}
+
+inline std::pair<uint32_t, uint32_t> random_u32_pair(uint64_t u) { return {u, u >> 32}; }
+
+inline double random_f53(uint64_t u) {
+    auto n = static_cast<int64_t>(u >> 11);
+    return n / 9007199254740992.0;
+}
+
+// Uses exponent injection instead of an int to double conversion. The top 52
+// bits j fill the mantissa of 1.0, and subtracting 1-2^-53 gives (2j+1)/2^53
+// exactly, the same value as (1 | u >> 11) / 2^53.
+inline double random_f52(uint64_t u) {
+    uint64_t n = UINT64_C(0x3ff0000000000000) | (u >> 12);
+    double d;
+    std::memcpy(&d, &n, sizeof(d));
+    return d - (1.0 - 0x1p-53);
+}
+
+// [0,1) from the top 24 bits of u
+inline float random_f24(uint32_t u) { return static_cast<float>(static_cast<int32_t>(u >> 8)) * 0x1p-24f; }
+
+// (0,1) from the top 23 bits of u by exponent injection, like random_f52
+inline float random_f23(uint32_t u) {
+    uint32_t n = UINT32_C(0x3f800000) | (u >> 9);
+    float f;
+    std::memcpy(&f, &n, sizeof(f));
+    return f - (1.0f - 0x1p-24f);
+}
+
+// fill [out, out+n) with convert(u) for words u drawn in blocks. The loop
+// has no dependencies between elements so the conversion is vectorized.
+template <typename RNG, typename F>
+void random_f64_fill(double *out, size_t n, RNG &rand, F convert) {
+    constexpr size_t BLOCK_SIZE = 256;
+    std::array<uint64_t, BLOCK_SIZE> u;
+    for(size_t k = 0; k < n; k += BLOCK_SIZE) {
+        size_t len = std::min(BLOCK_SIZE, n - k);
+        rand.fill_u64(u.data(), len);
+        for(size_t i = 0; i < len; ++i) {
+            out[k + i] = convert(u[i]);
+        }
+    }
+}
+
+// like random_f64_fill, but each word gives two floats, from its low and
+// then its high half. An odd n uses the low half of one more word.
+template <typename RNG, typename F>
+void random_f32_fill(float *out, size_t n, RNG &rand, F convert) {
+    constexpr size_t BLOCK_SIZE = 256;
+    std::array<uint64_t, BLOCK_SIZE> u;
+    for(size_t k = 0; k < n; k += 2 * BLOCK_SIZE) {
+        size_t len = std::min(2 * BLOCK_SIZE, n - k);
+        rand.fill_u64(u.data(), (len + 1) / 2);
+        float *block = out + k;
+        for(size_t i = 0; i < len / 2; ++i) {
+            block[2 * i] = convert(static_cast<uint32_t>(u[i]));
+            block[2 * i + 1] = convert(static_cast<uint32_t>(u[i] >> 32));
+        }
+        if(len % 2 == 1) {
+            block[len - 1] = convert(static_cast<uint32_t>(u[len / 2]));
+        }
+    }
+}
+
+inline double random_exp_inv(double f) { return -log(f); }
+
+// Ziggurat tables are generated at compile time.
+// The functions in this namespace are constexpr versions of the math
+// functions needed to build the tables. They work in long double and are
+// only intended for the arguments used below.
+namespace zig {
+constexpr long double LN2 = 0.693147180559945309417232121458176568L;
+constexpr long double SQRT2 = 1.41421356237309504880168872420969808L;
+constexpr long double SQRT_PI = 1.77245385090551602729816748334114518L;
+
+constexpr long double cexp(long double x) {
+    // x = k*ln(2) + r with |r| <= ln(2)/2
+    auto k = static_cast<int>(x / LN2 + (x < 0 ? -0.5L : 0.5L));
+    long double r = x - k * LN2;
+    long double sum = 1.0L;
+    long double term = 1.0L;
+    for(int i = 1; i < 30; ++i) {
+        term *= r / i;
+        sum += term;
+    }
+    for(; k > 0; --k) {
+        sum *= 2.0L;
+    }
+    for(; k < 0; ++k) {
+        sum /= 2.0L;
+    }
+    return sum;
+}
+
+constexpr long double clog(long double x) {
+    // x = 2^k*m with m in [sqrt(1/2),sqrt(2))
+    int k = 0;
+    for(; x >= SQRT2; ++k) {
+        x /= 2.0L;
+    }
+    for(; x < SQRT2 / 2.0L; --k) {
+        x *= 2.0L;
+    }
+    // log(m) = 2*atanh((m-1)/(m+1))
+    long double z = (x - 1.0L) / (x + 1.0L);
+    long double z2 = z * z;
+    long double sum = 0.0L;
+    for(int i = 1; i < 60; i += 2) {
+        sum += z / i;
+        z *= z2;
+    }
+    return 2.0L * sum + k * LN2;
+}
+
+constexpr long double csqrt(long double x) {
+    long double y = (x > 1.0L) ? x : 1.0L;
+    for(int i = 0; i < 100; ++i) {
+        y = (y + x / y) / 2.0L;
+    }
+    return y;
+}
+
+// continued fraction for erfc, only accurate for x >= 2
+constexpr long double cerfc(long double x) {
+    long double f = x;
+    for(int i = 1000; i > 0; --i) {
+        f = x + (i / 2.0L) / f;
+    }
+    return cexp(-x * x) / (SQRT_PI * f);
+}
+
+template <size_t N>
+struct Tables {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "The number of ziggurat layers must be a power of two.");
+    static constexpr uint64_t MASK = N - 1;
+    // the starting point of the tail
+    double r;
+    std::array<int64_t, N> k;
+    std::array<double, N> w;
+    std::array<double, N> f;
+};
+
+// Build the tables from the x and y coordinates of the layers.
+// Layer i spans the x values [x[i+1], x[i]), and layer 0 contains the tail.
+template <size_t N>
+constexpr Tables<N> make_tables(double r, const std::array<double, N + 1> &x, const std::array<double, N + 1> &y) {
+    Tables<N> t{r, {}, {}, {}};
+    for(size_t i = 0; i < N; ++i) {
+        long double u = 9223372036854775808.0L;
+        long double a = x[i + 1];
+        long double b = x[i];
+        t.k[i] = static_cast<int64_t>(u * (a / b));
+        t.w[i] = static_cast<double>(x[i] / u);
+        t.f[i] = y[i + 1];
+    }
+    return t;
+}
+
+// the starting point of the tail for exponential ziggurats
+template <size_t N>
+struct ExpTail;
+template <>
+struct ExpTail<128> {
+    static constexpr double r = 6.898315116615642;
+};
+template <>
+struct ExpTail<256> {
+    static constexpr double r = 7.69711747013104972;
+};
+template <>
+struct ExpTail<1024> {
+    static constexpr double r = 9.256164544265543;
+};
+
+// the starting point of the tail for normal ziggurats
+template <size_t N>
+struct NormalTail;
+template <>
+struct NormalTail<128> {
+    static constexpr double r = 3.442619855896652;
+};
+template <>
+struct NormalTail<256> {
+    static constexpr double r = 3.6541528853610088;
+};
+template <>
+struct NormalTail<1024> {
+    static constexpr double r = 4.038849846109504;
+};
+
+// f(x) = exp(-x)
+template <size_t N>
+constexpr Tables<N> make_exp_tables() {
+    constexpr double r = ExpTail<N>::r;
+    std::array<double, N + 1> x{};
+    std::array<double, N + 1> y{};
+    auto y1 = static_cast<double>(cexp(-r));
+    double t = y1;
+    double A = r * y1 + t;
+    x[0] = A / y1;
+    y[0] = 0;
+    x[1] = r;
+    y[1] = y1;
+    for(size_t i = 2; i < N; ++i) {
+        y[i] = y[i - 1] + A / x[i - 1];
+        x[i] = static_cast<double>(-clog(y[i]));
+    }
+    y[N] = 1.0;
+    x[N] = 0.0;
+    return make_tables<N>(r, x, y);
+}
+
+// f(x) = exp(-x*x/2)
+template <size_t N>
+constexpr Tables<N> make_normal_tables() {
+    constexpr double r = NormalTail<N>::r;
+    std::array<double, N + 1> x{};
+    std::array<double, N + 1> y{};
+    auto y1 = static_cast<double>(cexp(-0.5L * r * r));
+    // area of the tail
+    auto t = static_cast<double>(SQRT_PI / SQRT2 * cerfc(r / SQRT2));
+    double A = r * y1 + t;
+    x[0] = A / y1;
+    y[0] = 0;
+    x[1] = r;
+    y[1] = y1;
+    for(size_t i = 2; i < N; ++i) {
+        y[i] = y[i - 1] + A / x[i - 1];
+        x[i] = static_cast<double>(csqrt(-2.0L * clog(y[i])));
+    }
+    y[N] = 1.0;
+    x[N] = 0.0;
+    return make_tables<N>(r, x, y);
+}
+}  // namespace zig
+
+// Tables for exponential and normal ziggurats with N layers.
+// N = 128, 256, and 1024 are supported.
+template <size_t N>
+inline constexpr zig::Tables<N> exp_zig_tables = zig::make_exp_tables<N>();
+
+template <size_t N>
+inline constexpr zig::Tables<N> normal_zig_tables = zig::make_normal_tables<N>();
+
+template <size_t N = 256, typename callback>
+double random_exp_zig_internal(int64_t a, int b, callback &get) {
+    constexpr auto &zt = exp_zig_tables<N>;
+    RACUTILS_RANDOM_STAT(EXP_SLOW);
+    do {
+        if(b == 0) {
+            RACUTILS_RANDOM_STAT(EXP_TAIL);
+            RACUTILS_RANDOM_STAT(EXP_DRAWS);
+            return zt.r + random_exp_inv(random_f52(get()));
+        }
+        double x = a * zt.w[b];
+        RACUTILS_RANDOM_STAT(EXP_DRAWS);
+        if(zt.f[b - 1] + random_f52(get()) * (zt.f[b] - zt.f[b - 1]) < exp(-x)) {
+            return x;
+        }
+        RACUTILS_RANDOM_STAT(EXP_DRAWS);
+        a = random_i63(get());
+        b = static_cast<int>(a & zt.MASK);
+    } while(a > zt.k[b]);
+    return a * zt.w[b];
+}
+
+template <size_t N = 256, typename callback>
+inline double random_exp_zig(callback &get) {
+    constexpr auto &zt = exp_zig_tables<N>;
+    RACUTILS_RANDOM_STAT(EXP_CALLS);
+    RACUTILS_RANDOM_STAT(EXP_DRAWS);
+    int64_t a = random_i63(get());
+    auto b = static_cast<int>(a & zt.MASK);
+    if(a <= zt.k[b]) {
+        return a * zt.w[b];
+    }
+    return random_exp_zig_internal<N>(a, b, get);
+}
+
+// Ziggurat for the normal distribution (Marsaglia and Tsang 2000)
+// with the same table layout as the exponential ziggurat.
+// The magnitude is drawn like the exponential, and bit 0 of the draw,
+// which is not part of a, supplies the sign.
+template <size_t N = 256, typename callback>
+double random_normal_zig_internal(int64_t a, int b, callback &get) {
+    constexpr auto &zt = normal_zig_tables<N>;
+    RACUTILS_RANDOM_STAT(NORMAL_SLOW);
+    do {
+        if(b == 0) {
+            // draws of the tail are counted by random_exp_zig
+            RACUTILS_RANDOM_STAT(NORMAL_TAIL);
+            // sample from the tail (Marsaglia 1964)
+            double x, y;
+            do {
+                x = random_exp_zig(get) / zt.r;
+                y = random_exp_zig(get);
+            } while(2.0 * y < x * x);
+            return zt.r + x;
+        }
+        double x = a * zt.w[b];
+        RACUTILS_RANDOM_STAT(NORMAL_DRAWS);
+        if(zt.f[b - 1] + random_f52(get()) * (zt.f[b] - zt.f[b - 1]) < exp(-0.5 * x * x)) {
+            return x;
+        }
+        RACUTILS_RANDOM_STAT(NORMAL_DRAWS);
+        a = random_i63(get());
+        b = static_cast<int>(a & zt.MASK);
+    } while(a > zt.k[b]);
+    return a * zt.w[b];
+}
+
+// flip the sign bit of x with bit 0 of u, without a branch
+inline double random_normal_sign(uint64_t u, double x) {
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    bits ^= u << 63;
+    std::memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+template <size_t N = 256, typename callback>
+inline double random_normal_zig(callback &get) {
+    constexpr auto &zt = normal_zig_tables<N>;
+    RACUTILS_RANDOM_STAT(NORMAL_CALLS);
+    RACUTILS_RANDOM_STAT(NORMAL_DRAWS);
+    uint64_t u = get();
+    int64_t a = random_i63(u);
+    auto b = static_cast<int>(a & zt.MASK);
+    if(a <= zt.k[b]) {
+        return random_normal_sign(u, a * zt.w[b]);
+    }
+    return random_normal_sign(u, random_normal_zig_internal<N>(a, b, get));
+}
+
+// Runs the fast path of a ziggurat with tables zt over a block of n
+// uniform values. Accepted values are written to out. The positions of
+// rejected values are written to rejected, and the number of rejected
+// values is returned. Rejected values must be finished by the slow path of
+// the ziggurat, e.g. random_exp_zig_internal.
+template <size_t N>
+inline size_t random_zig_block(const uint64_t *u, size_t n, const zig::Tables<N> &zt, double *out,
+                               uint32_t *rejected) {
+    size_t i = 0;
+    size_t m = 0;
+#if defined(__AVX2__)
+    const __m256i mask = _mm256_set1_epi64x(zt.MASK);
+    const __m256i lo_mask = _mm256_set1_epi64x(0xffffffff);
+    const __m256i magic = _mm256_set1_epi64x(0x4330000000000000);
+    const __m256d magic_d = _mm256_set1_pd(4503599627370496.0);
+    const __m256d two32 = _mm256_set1_pd(4294967296.0);
+    for(; i + 4 <= n; i += 4) {
+        __m256i a = _mm256_srli_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(u + i)), 1);
+        __m256i b = _mm256_and_si256(a, mask);
+        __m256i kb = _mm256_i64gather_epi64(reinterpret_cast<const long long *>(zt.k.data()), b, 8);  // NOLINT
+        __m256d wb = _mm256_i64gather_pd(zt.w.data(), b, 8);
+        // convert a to double as hi*2^32+lo, which rounds once like a scalar conversion
+        __m256d hi = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(a, 32), magic)), magic_d);
+        __m256d lo = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(a, lo_mask), magic)), magic_d);
+        __m256d x = _mm256_add_pd(_mm256_mul_pd(hi, two32), lo);
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(x, wb));
+        // compact rejected lanes
+        auto bad = static_cast<unsigned int>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(a, kb))));
+        for(; bad != 0; bad &= bad - 1) {
+            rejected[m++] = static_cast<uint32_t>(i + __builtin_ctz(bad));
+        }
+    }
+#endif
+    // branch-free loop that compilers can vectorize with gathers
+    for(size_t j = i; j < n; ++j) {
+        int64_t a = random_i63(u[j]);
+        auto b = static_cast<int>(a & zt.MASK);
+        out[j] = a * zt.w[b];
+    }
+    // compact rejected positions
+    for(; i < n; ++i) {
+        int64_t a = random_i63(u[i]);
+        auto b = static_cast<int>(a & zt.MASK);
+        rejected[m] = static_cast<uint32_t>(i);
+        m += (a > zt.k[b]) ? 1 : 0;
+    }
+    return m;
+}
+
+// two values uniformly distributed in [0,b1) x [0,b2) from a single draw
+// when b1*b2 <= 2^64
+// Batched ranged random integers from Brackett-Rozinsky and Lemire (2024)
+// https://arxiv.org/abs/2408.06213
+template <typename callback>
+std::pair<uint64_t, uint64_t> random_u64_range_pair(uint64_t b1, uint64_t b2, callback &get) {
+    assert(static_cast<__uint128_t>(b1) * b2 <= (static_cast<__uint128_t>(1) << 64));
+    __uint128_t m1 = static_cast<__uint128_t>(get()) * b1;
+    __uint128_t m2 = static_cast<__uint128_t>(static_cast<uint64_t>(m1)) * b2;
+    auto l = static_cast<uint64_t>(m2);
+    uint64_t p = b1 * b2;
+    if(l < p) {
+        uint64_t t = random_u64_threshold(p);
+        while(l < t) {
+            m1 = static_cast<__uint128_t>(get()) * b1;
+            m2 = static_cast<__uint128_t>(static_cast<uint64_t>(m1)) * b2;
+            l = static_cast<uint64_t>(m2);
+        }
+    }
+    return {static_cast<uint64_t>(m1 >> 64), static_cast<uint64_t>(m2 >> 64)};
+}
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+inline void prefetch(const void *p) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p);
+#else
+    (void)p;
+#endif
+}
+
+}  // namespace details
+
+template <typename Engine>
+class BasicRandom : public Engine {
+   public:
+    using engine_type = Engine;
+    // import constructor
+    using engine_type::engine_type;
+    BasicRandom() = default;
+    explicit BasicRandom(const engine_type &engine) : engine_type(engine) {}
+    // import seed_type
+    using seed_type = typename engine_type::seed_type;
+
+    // code sanity check
+    static_assert(std::is_same<uint64_t, typename engine_type::result_type>::value,
+                  "The result type of the engine is not a uint64_t.");
+
+    uint64_t bits();
+    uint64_t bits(int b);
+
+    // same as bits(), so that samplers calling rand() are counted by stats()
+    uint64_t operator()() { return bits(); }
+
+    uint64_t u64();
+    uint64_t u64(uint64_t range);
+    void u64_fill(uint64_t range, uint64_t *out, size_t n);
+
+    uint32_t u32();
+    std::pair<uint32_t, uint32_t> u32_pair();
+
+    void fill_u64(uint64_t *out, size_t n);
+
+    // randomly permute [first, last)
+    template <typename RandomIt>
+    void shuffle(RandomIt first, RandomIt last);
+
+    // write k distinct values from [0,n) in increasing order to out
+    template <typename OutputIt>
+    OutputIt sample_k(uint64_t n, uint64_t k, OutputIt out);
+
+    double f52();
+    double f53();
+    float f23();
+    float f24();
+    std::pair<float, float> f23_pair();
+    std::pair<float, float> f24_pair();
+
+    // fill [out, out+n) with the values of f52(), f53(), f23() or f24().
+    // Float fills use both halves of each word, like the pair functions.
+    void f52_fill(double *out, size_t n);
+    void f53_fill(double *out, size_t n);
+    void f23_fill(float *out, size_t n);
+    void f24_fill(float *out, size_t n);
+
+    // layers selects the size of the ziggurat tables
+    template <size_t layers = 256>
+    double exp(double mean = 1.0);
+    template <size_t layers = 256>
+    void exp_fill(double *out, size_t n, double mean = 1.0);
+
+    template <size_t layers = 256>
+    double normal(double mean = 0.0, double sd = 1.0);
+    template <size_t layers = 256>
+    void normal_fill(double *out, size_t n, double mean = 0.0, double sd = 1.0);
+
+    template <size_t count>
+    void Seed(const SeedSeq<count> &ss);
+    void Seed(const uint32_t s);
+    using engine_type::Seed;
+
+    BasicRandom Jump(size_t count) const;
+    // only available if the engine supports them
+    BasicRandom Jump() const;
+    BasicRandom LongJump() const;
+
+    BasicRandom Stream(uint64_t k) const;
+
+    // only available for counter-based engines
+    uint64_t u64(uint64_t stream, uint64_t counter) const;
+};
+
+using Random = BasicRandom<details::RandomEngine>;
+using PhiloxRandom = BasicRandom<details::Philox2x64>;
+
+// uniformly distributed between [0,2^64)
+template <typename Engine>
+inline uint64_t BasicRandom<Engine>::bits() {
+    RACUTILS_RANDOM_STAT(ENGINE_DRAWS);
+    return engine_type::operator()();
+}
+// uniformly distributed between [0,2^b)
+template <typename Engine>
+inline uint64_t BasicRandom<Engine>::bits(int b) { return bits() >> (64 - b); }
+
+// uniformly distributed between [0,2^64)
+template <typename Engine>
+inline uint64_t BasicRandom<Engine>::u64() { return bits(); }
+
+// uniformly distributed between [0,range)
+template <typename Engine>
+inline uint64_t BasicRandom<Engine>::u64(uint64_t range) { return details::random_u64_range(range, *this); }
+
+// fill [out, out+n) with values uniformly distributed between [0,range)
+// Produces the same values as calling u64(range) n times.
+template <typename Engine>
+inline void BasicRandom<Engine>::u64_fill(uint64_t range, uint64_t *out, size_t n) {
+    details::random_u64_range_fill(range, details::random_u64_threshold(range), out, n, *this);
+}
+
+// draw counter of stream, uniformly distributed between [0,2^64)
+template <typename Engine>
+inline uint64_t BasicRandom<Engine>::u64(uint64_t stream, uint64_t counter) const {
+    return engine_type::At(stream, counter);
+}
+
+// uniformly distributed between [0,2^32)
+template <typename Engine>
+inline uint32_t BasicRandom<Engine>::u32() { return details::random_u32(bits()); }
+
+// uniformly distributed pair between [0,2^32)
+template <typename Engine>
+inline std::pair<uint32_t, uint32_t> BasicRandom<Engine>::u32_pair() { return details::random_u32_pair(bits()); }
+
+// fill [out, out+n) with values uniformly distributed between [0,2^64)
+// produces the same values as calling u64() n times
+template <typename Engine>
+inline void BasicRandom<Engine>::fill_u64(uint64_t *out, size_t n) {
+    RACUTILS_RANDOM_STAT_ADD(ENGINE_DRAWS, n);
+    engine_type::Fill(out, n);
+}
+
+// Fisher-Yates shuffle. While both ranges fit, the swap targets of two
+// positions are taken from a single draw. Targets are generated a block at
+// a time, so that they can be prefetched before the swaps.
+template <typename Engine>
+template <typename RandomIt>
+inline void BasicRandom<Engine>::shuffle(RandomIt first, RandomIt last) {
+    constexpr size_t BLOCK_SIZE = 256;
+    constexpr size_t PREFETCH_DISTANCE = 32;
+    constexpr uint64_t PAIR_LIMIT = UINT64_C(1) << 32;
+    std::array<uint64_t, BLOCK_SIZE> j;
+    assert(first <= last);
+    auto i = static_cast<uint64_t>(last - first);
+    RACUTILS_RANDOM_STAT_ADD(SHUFFLE_CALLS, i);
+    RACUTILS_RANDOM_STAT_DRAWS(SHUFFLE_DRAWS);
+    while(i > 1) {
+        // j[k] is the swap target of position i-1-k, drawn from [0,i-k)
+        size_t len = std::min<uint64_t>(BLOCK_SIZE, i - 1);
+        size_t k = 0;
+        for(; k < len && i - k > PAIR_LIMIT; ++k) {
+            j[k] = u64(i - k);
+        }
+        for(; k + 1 < len; k += 2) {
+            auto jj = details::random_u64_range_pair(i - k, i - k - 1, *this);
+            j[k] = jj.first;
+            j[k + 1] = jj.second;
+        }
+        if(k < len) {
+            j[k] = u64(i - k);
+        }
+        for(k = 0; k < len && k < PREFETCH_DISTANCE; ++k) {
+            details::prefetch(&*(first + j[k]));
+        }
+        for(k = 0; k < len; ++k) {
+            if(k + PREFETCH_DISTANCE < len) {
+                details::prefetch(&*(first + j[k + PREFETCH_DISTANCE]));
+            }
+            std::iter_swap(first + (i - 1 - k), first + j[k]);
+        }
+        i -= len;
+    }
+}
+
+// Sparse samples draw values with replacement, two per engine draw while n
+// fits in 32 bits, then sort them and drop duplicates, and repeat for the
+// missing values until k are left. This stores only the k values. Dense
+// samples, with n < 13k, use Vitter's Algorithm A: one uniform per output
+// gives the number of values to skip before it. The two paths use O(k) draws.
+// J. S. Vitter (1984) Faster methods for random sampling.
+// https://doi.org/10.1145/358105.893
+template <typename Engine>
+template <typename OutputIt>
+inline OutputIt BasicRandom<Engine>::sample_k(uint64_t n, uint64_t k, OutputIt out) {
+    constexpr uint64_t DENSE_RATIO = 13;
+    constexpr uint64_t PAIR_LIMIT = UINT64_C(1) << 32;
+    assert(k <= n);
+    RACUTILS_RANDOM_STAT_ADD(SAMPLE_K_CALLS, k);
+    RACUTILS_RANDOM_STAT_DRAWS(SAMPLE_K_DRAWS);
+    if(n / DENSE_RATIO < k) {
+        // i is the next candidate and left the number of candidates from i on
+        uint64_t i = 0;
+        uint64_t left = n;
+        for(; k > 1; --k) {
+            double v = f53();
+            uint64_t top = left - k;
+            double quot = static_cast<double>(top) / static_cast<double>(left);
+            uint64_t skip = 0;
+            while(quot > v) {
+                ++skip;
+                --top;
+                quot *= static_cast<double>(top) / static_cast<double>(left - skip);
+            }
+            i += skip;
+            *out++ = i++;
+            left -= skip + 1;
+        }
+        if(k == 1) {
+            *out++ = i + u64(left);
+        }
+        return out;
+    }
+    std::vector<uint64_t> v;
+    v.reserve(k);
+    while(v.size() < k) {
+        size_t old = v.size();
+        v.resize(k);
+        size_t i = old;
+        if(n <= PAIR_LIMIT) {
+            for(; i + 1 < v.size(); i += 2) {
+                auto jj = details::random_u64_range_pair(n, n, *this);
+                v[i] = jj.first;
+                v[i + 1] = jj.second;
+            }
+        }
+        for(; i < v.size(); ++i) {
+            v[i] = u64(n);
+        }
+        std::sort(v.begin() + old, v.end());
+        std::inplace_merge(v.begin(), v.begin() + old, v.end());
+        v.erase(std::unique(v.begin(), v.end()), v.end());
+    }
+    return std::copy(v.begin(), v.end(), out);
+}
+
+// uniformly distributed between (0,1.0)
+template <typename Engine>
+inline double BasicRandom<Engine>::f52() { return details::random_f52(bits()); }
+
+// uniformly distributed between [0,1.0)
+template <typename Engine>
+inline double BasicRandom<Engine>::f53() { return details::random_f53(bits()); }
+
+// uniformly distributed float between (0,1.0)
+template <typename Engine>
+inline float BasicRandom<Engine>::f23() { return details::random_f23(u32()); }
+
+// uniformly distributed float between [0,1.0)
+template <typename Engine>
+inline float BasicRandom<Engine>::f24() { return details::random_f24(u32()); }
+
+// two floats between (0,1.0) from one draw
+template <typename Engine>
+inline std::pair<float, float> BasicRandom<Engine>::f23_pair() {
+    auto p = u32_pair();
+    return {details::random_f23(p.first), details::random_f23(p.second)};
+}
+
+// two floats between [0,1.0) from one draw
+template <typename Engine>
+inline std::pair<float, float> BasicRandom<Engine>::f24_pair() {
+    auto p = u32_pair();
+    return {details::random_f24(p.first), details::random_f24(p.second)};
+}
+
+template <typename Engine>
+inline void BasicRandom<Engine>::f52_fill(double *out, size_t n) {
+    details::random_f64_fill(out, n, *this, [](uint64_t u) { return details::random_f52(u); });
+}
+
+template <typename Engine>
+inline void BasicRandom<Engine>::f53_fill(double *out, size_t n) {
+    details::random_f64_fill(out, n, *this, [](uint64_t u) { return details::random_f53(u); });
+}
+
+template <typename Engine>
+inline void BasicRandom<Engine>::f23_fill(float *out, size_t n) {
+    details::random_f32_fill(out, n, *this, [](uint32_t u) { return details::random_f23(u); });
+}
+
+template <typename Engine>
+inline void BasicRandom<Engine>::f24_fill(float *out, size_t n) {
+    details::random_f32_fill(out, n, *this, [](uint32_t u) { return details::random_f24(u); });
+}
+
+// exponential random value with specified mean. mean=1.0/rate
+template <typename Engine>
+template <size_t layers>
+inline double BasicRandom<Engine>::exp(double mean) {
+    return details::random_exp_zig<layers>(*this) * mean;
+}
+
+// fill [out, out+n) with exponential random values with specified mean.
+// Each block of uniforms goes through the fast path together, and only the
+// rejected values are finished one at a time.
+template <typename Engine>
+template <size_t layers>
+inline void BasicRandom<Engine>::exp_fill(double *out, size_t n, double mean) {
+    constexpr auto &zt = details::exp_zig_tables<layers>;
+    constexpr size_t BLOCK_SIZE = 256;
+    std::array<uint64_t, BLOCK_SIZE> u;
+    std::array<uint32_t, BLOCK_SIZE> rejected;
+    for(size_t k = 0; k < n; k += BLOCK_SIZE) {
+        size_t len = std::min(BLOCK_SIZE, n - k);
+        double *block = out + k;
+        fill_u64(u.data(), len);
+        size_t m = details::random_zig_block(u.data(), len, zt, block, rejected.data());
+        RACUTILS_RANDOM_STAT_ADD(EXP_CALLS, len);
+        RACUTILS_RANDOM_STAT_ADD(EXP_DRAWS, len);
+        for(size_t j = 0; j < m; ++j) {
+            uint32_t i = rejected[j];
+            int64_t a = details::random_i63(u[i]);
+            auto b = static_cast<int>(a & zt.MASK);
+            block[i] = details::random_exp_zig_internal<layers>(a, b, *this);
+        }
+        for(size_t i = 0; i < len; ++i) {
+            block[i] *= mean;
+        }
+    }
+}
+
+// normal random value with specified mean and standard deviation
+template <typename Engine>
+template <size_t layers>
+inline double BasicRandom<Engine>::normal(double mean, double sd) {
+    return mean + details::random_normal_zig<layers>(*this) * sd;
+}
+
+// fill [out, out+n) with normal random values with specified mean and
+// standard deviation. Works in blocks like exp_fill.
+template <typename Engine>
+template <size_t layers>
+inline void BasicRandom<Engine>::normal_fill(double *out, size_t n, double mean, double sd) {
+    constexpr auto &zt = details::normal_zig_tables<layers>;
+    constexpr size_t BLOCK_SIZE = 256;
+    std::array<uint64_t, BLOCK_SIZE> u;
+    std::array<uint32_t, BLOCK_SIZE> rejected;
+    for(size_t k = 0; k < n; k += BLOCK_SIZE) {
+        size_t len = std::min(BLOCK_SIZE, n - k);
+        double *block = out + k;
+        fill_u64(u.data(), len);
+        size_t m = details::random_zig_block(u.data(), len, zt, block, rejected.data());
+        RACUTILS_RANDOM_STAT_ADD(NORMAL_CALLS, len);
+        RACUTILS_RANDOM_STAT_ADD(NORMAL_DRAWS, len);
+        for(size_t j = 0; j < m; ++j) {
+            uint32_t i = rejected[j];
+            int64_t a = details::random_i63(u[i]);
+            auto b = static_cast<int>(a & zt.MASK);
+            block[i] = details::random_normal_zig_internal<layers>(a, b, *this);
+        }
+        for(size_t i = 0; i < len; ++i) {
+            block[i] = mean + details::random_normal_sign(u[i], block[i]) * sd;
+        }
+    }
+}
+
+// returns a copy of the generator advanced by count draws
+template <typename Engine>
+inline BasicRandom<Engine> BasicRandom<Engine>::Jump(size_t count) const {
+    return BasicRandom{engine_type::Jump(count)};
+}
+
+// returns a copy of the generator advanced by the engine's jump distance
+template <typename Engine>
+inline BasicRandom<Engine> BasicRandom<Engine>::Jump() const {
+    return BasicRandom{engine_type::Jump()};
+}
+
+// returns a copy of the generator advanced by the engine's long-jump distance
+template <typename Engine>
+inline BasicRandom<Engine> BasicRandom<Engine>::LongJump() const {
+    return BasicRandom{engine_type::LongJump()};
+}
+
+// returns a copy of the generator moved to the start of substream k
+// Substreams are spaced by 2^64 draws for Lehmer64Fast and 2^128 draws for Xoshiro256StarStar.
+template <typename Engine>
+inline BasicRandom<Engine> BasicRandom<Engine>::Stream(uint64_t k) const {
+    return BasicRandom{engine_type::Stream(k)};
+}
+
+// BasicBufferedRandom serves draws from a cache-aligned block of engine
+// output that is refilled with fill_u64, and packs sub-word requests into a
+// bit reservoir so that bits(b), u32() and coin() only consume the bits they
+// use. It produces a different sequence than BasicRandom for the same seed.
+// It pays off when engine output is expensive, e.g. Philox2x64, or when most
+// requests are a few bits; with Lehmer64Fast a full draw costs about as much
+// as the reservoir bookkeeping.
+template <typename Engine>
+class BasicBufferedRandom {
+   public:
+    using random_type = BasicRandom<Engine>;
+    using result_type = uint64_t;
+
+    static constexpr size_t BUFFER_SIZE = 64;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    BasicBufferedRandom() = default;
+    explicit BasicBufferedRandom(const random_type &rand) : rand_{rand} {}
+
+    // seed the underlying generator and discard buffered output
+    template <typename... Args>
+    void Seed(Args &&...args) {
+        rand_.Seed(std::forward<Args>(args)...);
+        pos_ = BUFFER_SIZE;
+        reservoir_ = 0;
+        avail_ = 0;
+    }
+
+    // uniformly distributed between [0,2^64)
+    uint64_t bits() {
+        RACUTILS_RANDOM_STAT(BUFFERED_CALLS);
+        return Word();
+    }
+
+    // uniformly distributed between [0,2^b) for 0 < b <= 64
+    uint64_t bits(int b) {
+        assert(0 < b && b <= 64);
+        RACUTILS_RANDOM_STAT(BUFFERED_CALLS);
+        if(b < 64 && b <= avail_) {
+            avail_ -= b;
+            return (reservoir_ >> avail_) & ((UINT64_C(1) << b) - 1);
+        }
+        return BitsSlow(b);
+    }
+
+    uint64_t operator()() { return bits(); }
+
+    uint64_t u64() { return bits(); }
+    uint64_t u64(uint64_t range) { return details::random_u64_range(range, *this); }
+    uint32_t u32() { return static_cast<uint32_t>(bits(32)); }
+    bool coin() { return bits(1) != 0; }
+
+    // floating-point values use whole words; packing 52 or 53 bits costs more than it saves
+    double f52() { return details::random_f52(bits()); }
+    double f53() { return details::random_f53(bits()); }
+
+    template <size_t layers = 256>
+    double exp(double mean = 1.0) {
+        return details::random_exp_zig<layers>(*this) * mean;
+    }
+    template <size_t layers = 256>
+    double normal(double mean = 0.0, double sd = 1.0) {
+        return mean + details::random_normal_zig<layers>(*this) * sd;
+    }
+
+    // fill [out, out+n) with values uniformly distributed between [0,2^64)
+    void fill_u64(uint64_t *out, size_t n);
+
+    random_type &base() { return rand_; }
+    const random_type &base() const { return rand_; }
+
+   private:
+    // the next buffered word
+    uint64_t Word() {
+        RACUTILS_RANDOM_STAT(BUFFERED_DRAWS);
+        if(pos_ == BUFFER_SIZE) {
+            Refill();
+        }
+        return buffer_[pos_++];
+    }
+
+    void Refill() {
+        RACUTILS_RANDOM_STAT(BUFFERED_SLOW);
+        rand_.fill_u64(buffer_.data(), BUFFER_SIZE);
+        pos_ = 0;
+    }
+
+    uint64_t BitsSlow(int b);
+
+    random_type rand_;
+    alignas(details::CACHE_LINE_SIZE) std::array<uint64_t, BUFFER_SIZE> buffer_;
+    size_t pos_{BUFFER_SIZE};
+    // the next bits are the low avail_ bits of reservoir_, from the top down
+    uint64_t reservoir_{0};
+    int avail_{0};
+};
+
+template <typename Engine>
+inline uint64_t BasicBufferedRandom<Engine>::BitsSlow(int b) {
+    if(b == 64) {
+        return Word();
+    }
+    // use the remaining bits and take the rest from a new word
+    uint64_t w = Word();
+    int need = b - avail_;
+    uint64_t r = ((reservoir_ & ((UINT64_C(1) << avail_) - 1)) << need) | (w >> (64 - need));
+    reservoir_ = w;
+    avail_ = 64 - need;
+    return r;
+}
+
+template <typename Engine>
+inline void BasicBufferedRandom<Engine>::fill_u64(uint64_t *out, size_t n) {
+    RACUTILS_RANDOM_STAT_ADD(BUFFERED_CALLS, n);
+    RACUTILS_RANDOM_STAT_ADD(BUFFERED_DRAWS, n);
+    size_t m = std::min(n, BUFFER_SIZE - pos_);
+    std::copy_n(buffer_.begin() + pos_, m, out);
+    pos_ += m;
+    rand_.fill_u64(out + m, n - m);
+}
+
+using BufferedRandom = BasicBufferedRandom<details::RandomEngine>;
+
+// BoundedSampler draws integers uniformly from [0,range) for a fixed range.
+// The rejection threshold is computed once, instead of on every slow path.
+// It produces the same values as u64(range).
+class BoundedSampler {
+   public:
+    explicit BoundedSampler(uint64_t range) : range_{range}, threshold_{details::random_u64_threshold(range)} {}
+
+    template <typename RNG>
+    uint64_t operator()(RNG &rand) const {
+        return details::random_u64_range(range_, threshold_, rand);
+    }
+
+    // fill [out, out+n) with samples using rand
+    template <typename RNG>
+    void Fill(RNG &rand, uint64_t *out, size_t n) const {
+        details::random_u64_range_fill(range_, threshold_, out, n, rand);
+    }
+
+    uint64_t range() const { return range_; }
+    uint64_t threshold() const { return threshold_; }
+
+   private:
+    uint64_t range_;
+    uint64_t threshold_;
+};
+
+namespace details {
+// log(k!) using a table for small k and Stirling's series otherwise
+inline double log_factorial(uint64_t k) {
+    static constexpr double table[10] = {0.0,
+                                         0.0,
+                                         0.69314718055994530942,
+                                         1.79175946922805500081,
+                                         3.17805383034794561964,
+                                         4.78749174278204599425,
+                                         6.57925121201010099506,
+                                         8.52516136106541430017,
+                                         10.60460290274525022842,
+                                         12.80182748008146961121};
+    if(k < 10) {
+        return table[k];
+    }
+    double x = static_cast<double>(k);
+    double r = 1.0 / (x * x);
+    return (x + 0.5) * std::log(x) - x + 0.91893853320467274178 +
+           (1.0 / 12.0 - (1.0 / 360.0 - (1.0 / 1260.0 - r / 1680.0) * r) * r) / x;
+}
+
+// Cumulative probabilities of a discrete distribution for sampling by
+// inversion. pmf0 is P(0) and ratio(k) returns P(k+1)/P(k). The table
+// stops once the remaining mass is negligible; its last entry is set to
+// infinity so that the search always ends.
+template <typename Ratio>
+std::vector<double> inversion_table(double pmf0, double mean, uint64_t max_k, Ratio &&ratio) {
+    std::vector<double> cdf;
+    double pmf = pmf0;
+    double sum = pmf0;
+    cdf.push_back(sum);
+    for(uint64_t k = 0; k < max_k && (k <= mean || pmf > 1e-20); ++k) {
+        pmf *= ratio(k);
+        sum += pmf;
+        cdf.push_back(sum);
+    }
+    cdf.back() = std::numeric_limits<double>::infinity();
+    return cdf;
+}
+
+// the smallest k with u < cdf[k]
+inline uint64_t inversion_search(const std::vector<double> &cdf, double u) {
+    uint64_t k = 0;
+    for(; !(u < cdf[k]); ++k) {
+        /*noop*/;
+    }
+    return k;
+}
+}  // namespace details
+
+// Poisson draws from a Poisson distribution with a fixed mean.
+// Means below INVERSION_LIMIT use inversion over a precomputed table.
+// Larger means use PTRS, the transformed rejection method of Hörmann (1993)
+// The transformed rejection method for generating Poisson random variables.
+// https://doi.org/10.1016/0167-6687(93)90997-4
+class Poisson {
+   public:
+    static constexpr double INVERSION_LIMIT = 10.0;
+
+    explicit Poisson(double mean);
+
+    template <typename RNG>
+    uint64_t operator()(RNG &rand) const {
+        RACUTILS_RANDOM_STAT(POISSON_CALLS);
+        RACUTILS_RANDOM_STAT_DRAWS(POISSON_DRAWS);
+        return (mean_ < INVERSION_LIMIT) ? details::inversion_search(cdf_, rand.f52()) : Ptrs(rand);
+    }
+
+    // fill [out, out+n) with samples using rand
+    template <typename RNG>
+    void Fill(RNG &rand, uint64_t *out, size_t n) const {
+        for(size_t i = 0; i < n; ++i) {
+            out[i] = operator()(rand);
+        }
+    }
+
+    double mean() const { return mean_; }
+
+   private:
+    template <typename RNG>
+    uint64_t Ptrs(RNG &rand) const;
+
+    double mean_;
+    // inversion
+    std::vector<double> cdf_;
+    // PTRS
+    double a_{0}, b_{0}, vr_{0}, log_inv_alpha_{0}, log_mean_{0};
+};
+
+inline Poisson::Poisson(double mean) : mean_{mean} {
+    assert(mean >= 0.0);
+    if(mean_ < INVERSION_LIMIT) {
+        cdf_ = details::inversion_table(std::exp(-mean_), mean_, UINT64_MAX,
+                                        [this](uint64_t k) { return mean_ / static_cast<double>(k + 1); });
+        return;
+    }
+    double smu = std::sqrt(mean_);
+    b_ = 0.931 + 2.53 * smu;
+    a_ = -0.059 + 0.02483 * b_;
+    vr_ = 0.9277 - 3.6224 / (b_ - 2.0);
+    log_inv_alpha_ = std::log(1.1239 + 1.1328 / (b_ - 3.4));
+    log_mean_ = std::log(mean_);
+}
+
+template <typename RNG>
+inline uint64_t Poisson::Ptrs(RNG &rand) const {
+    for(;;) {
+        double u = rand.f52() - 0.5;
+        double v = rand.f52();
+        double us = 0.5 - std::fabs(u);
+        double k = std::floor((2.0 * a_ / us + b_) * u + mean_ + 0.43);
+        if(us >= 0.07 && v <= vr_) {
+            return static_cast<uint64_t>(k);
+        }
+        if(k < 0.0 || (us < 0.013 && v > us)) {
+            RACUTILS_RANDOM_STAT(POISSON_SLOW);
+            continue;
+        }
+        auto ik = static_cast<uint64_t>(k);
+        if(std::log(v) + log_inv_alpha_ - std::log(a_ / (us * us) + b_) <=
+           -mean_ + k * log_mean_ - details::log_factorial(ik)) {
+            return ik;
+        }
+        RACUTILS_RANDOM_STAT(POISSON_SLOW);
+    }
+}
+
+// Binomial draws from a binomial distribution with fixed n and p.
+// Distributions with min(p,1-p)*n below INVERSION_LIMIT use inversion over
+// a precomputed table. Others use BTRS, the binomial counterpart of PTRS
+// from Hörmann (1993) The generation of binomial random variates.
+// https://doi.org/10.1080/00949659308811496
+class Binomial {
+   public:
+    static constexpr double INVERSION_LIMIT = 10.0;
+
+    Binomial(uint64_t n, double p);
+
+    template <typename RNG>
+    uint64_t operator()(RNG &rand) const {
+        RACUTILS_RANDOM_STAT(BINOMIAL_CALLS);
+        RACUTILS_RANDOM_STAT_DRAWS(BINOMIAL_DRAWS);
+        uint64_t k = (n_ * p_ < INVERSION_LIMIT) ? details::inversion_search(cdf_, rand.f52()) : Btrs(rand);
+        return flip_ ? n_ - k : k;
+    }
+
+    // fill [out, out+n) with samples using rand
+    template <typename RNG>
+    void Fill(RNG &rand, uint64_t *out, size_t n) const {
+        for(size_t i = 0; i < n; ++i) {
+            out[i] = operator()(rand);
+        }
+    }
+
+    uint64_t n() const { return n_; }
+    double p() const { return flip_ ? 1.0 - p_ : p_; }
+
+   private:
+    template <typename RNG>
+    uint64_t Btrs(RNG &rand) const;
+
+    uint64_t n_;
+    // p_ <= 0.5; samples are reflected if the original p was larger
+    double p_;
+    bool flip_;
+    // inversion
+    std::vector<double> cdf_;
+    // BTRS
+    double a_{0}, b_{0}, c_{0}, vr_{0}, log_alpha_{0}, lpq_{0}, h_{0};
+    double m_{0};
+};
+
+inline Binomial::Binomial(uint64_t n, double p) : n_{n}, p_{std::min(p, 1.0 - p)}, flip_{p > 0.5} {
+    assert(0.0 <= p && p <= 1.0);
+    double q = 1.0 - p_;
+    if(n_ * p_ < INVERSION_LIMIT) {
+        double r = p_ / q;
+        cdf_ = details::inversion_table(std::exp(static_cast<double>(n_) * std::log1p(-p_)), n_ * p_, n_,
+                                        [this, r](uint64_t k) { return r * static_cast<double>(n_ - k) / (k + 1); });
+        return;
+    }
+    double spq = std::sqrt(n_ * p_ * q);
+    b_ = 1.15 + 2.53 * spq;
+    a_ = -0.0873 + 0.0248 * b_ + 0.01 * p_;
+    c_ = n_ * p_ + 0.5;
+    vr_ = 0.92 - 4.2 / b_;
+    log_alpha_ = std::log((2.83 + 5.1 / b_) * spq);
+    lpq_ = std::log(p_ / q);
+    m_ = std::floor((n_ + 1) * p_);
+    auto m = static_cast<uint64_t>(m_);
+    h_ = details::log_factorial(m) + details::log_factorial(n_ - m);
+}
+
+template <typename RNG>
+inline uint64_t Binomial::Btrs(RNG &rand) const {
+    for(;;) {
+        double u = rand.f52() - 0.5;
+        double v = rand.f52();
+        double us = 0.5 - std::fabs(u);
+        double k = std::floor((2.0 * a_ / us + b_) * u + c_);
+        if(k < 0.0 || k > static_cast<double>(n_)) {
+            RACUTILS_RANDOM_STAT(BINOMIAL_SLOW);
+            continue;
+        }
+        auto ik = static_cast<uint64_t>(k);
+        if(us >= 0.07 && v <= vr_) {
+            return ik;
+        }
+        if(std::log(v) + log_alpha_ - std::log(a_ / (us * us) + b_) <=
+           h_ - details::log_factorial(ik) - details::log_factorial(n_ - ik) + (k - m_) * lpq_) {
+            return ik;
+        }
+        RACUTILS_RANDOM_STAT(BINOMIAL_SLOW);
+    }
+}
+
+// Gamma draws from a gamma distribution with fixed shape and scale, using
+// Marsaglia and Tsang (2000) A simple method for generating gamma variables.
+// https://doi.org/10.1145/358407.358414
+// Shapes below 1 draw from shape+1 and multiply by U^(1/shape) = exp(-E/shape).
+class Gamma {
+   public:
+    explicit Gamma(double shape, double scale = 1.0);
+
+    template <typename RNG>
+    double operator()(RNG &rand) const {
+        RACUTILS_RANDOM_STAT_DRAWS(GAMMA_DRAWS);
+        double x = Draw(rand);
+        if(boost_) {
+            x *= std::exp(-rand.exp() / shape_);
+        }
+        return x * scale_;
+    }
+
+    // log of a draw, which stays finite for tiny shapes where a draw underflows
+    template <typename RNG>
+    double Log(RNG &rand) const {
+        RACUTILS_RANDOM_STAT_DRAWS(GAMMA_DRAWS);
+        double x = std::log(Draw(rand) * scale_);
+        return boost_ ? x - rand.exp() / shape_ : x;
+    }
+
+    // fill [out, out+n) with samples using rand
+    // Produces the same values as n calls, which is faster than drawing the
+    // normals in bulk because most trials are accepted by the squeeze.
+    template <typename RNG>
+    void Fill(RNG &rand, double *out, size_t n) const;
+
+    double shape() const { return shape_; }
+    double scale() const { return scale_; }
+
+   private:
+    // one trial from a standard normal z and a uniform u; returns -1 on rejection
+    double Trial(double z, double u) const {
+        double v = 1.0 + c_ * z;
+        if(v <= 0.0) {
+            return -1.0;
+        }
+        v = v * v * v;
+        double z2 = z * z;
+        if(u < 1.0 - 0.0331 * z2 * z2 || std::log(u) < 0.5 * z2 + d_ * (1.0 - v + std::log(v))) {
+            return d_ * v;
+        }
+        return -1.0;
+    }
+
+    template <typename RNG>
+    double Draw(RNG &rand) const {
+        RACUTILS_RANDOM_STAT(GAMMA_CALLS);
+        for(;;) {
+            double x = Trial(rand.normal(), rand.f52());
+            if(x >= 0.0) {
+                return x;
+            }
+            RACUTILS_RANDOM_STAT(GAMMA_SLOW);
+        }
+    }
+
+    double shape_;
+    double scale_;
+    bool boost_;
+    double d_;
+    double c_;
+};
+
+inline Gamma::Gamma(double shape, double scale) : shape_{shape}, scale_{scale}, boost_{shape < 1.0} {
+    assert(shape > 0.0);
+    d_ = (boost_ ? shape_ + 1.0 : shape_) - 1.0 / 3.0;
+    c_ = 1.0 / std::sqrt(9.0 * d_);
+}
+
+template <typename RNG>
+inline void Gamma::Fill(RNG &rand, double *out, size_t n) const {
+    for(size_t i = 0; i < n; ++i) {
+        out[i] = operator()(rand);
+    }
+}
+
+// Beta draws X/(X+Y) where X ~ Gamma(a) and Y ~ Gamma(b). When either shape
+// is below 1 the ratio is formed from logs to avoid 0/0 underflow.
+class Beta {
+   public:
+    Beta(double a, double b) : x_{a}, y_{b}, logs_{std::min(a, b) < 1.0} {}
+
+    template <typename RNG>
+    double operator()(RNG &rand) const {
+        RACUTILS_RANDOM_STAT(BETA_CALLS);
+        RACUTILS_RANDOM_STAT_DRAWS(BETA_DRAWS);
+        if(logs_) {
+            double lx = x_.Log(rand);
+            double ly = y_.Log(rand);
+            return 1.0 / (1.0 + std::exp(ly - lx));
+        }
+        double x = x_(rand);
+        double y = y_(rand);
+        return x / (x + y);
+    }
+
+    // fill [out, out+n) with samples using rand
+    template <typename RNG>
+    void Fill(RNG &rand, double *out, size_t n) const;
+
+    double a() const { return x_.shape(); }
+    double b() const { return y_.shape(); }
+
+   private:
+    Gamma x_;
+    Gamma y_;
+    bool logs_;
+};
+
+template <typename RNG>
+inline void Beta::Fill(RNG &rand, double *out, size_t n) const {
+    for(size_t i = 0; i < n; ++i) {
+        out[i] = operator()(rand);
+    }
+}
+
+// Dirichlet draws probability vectors whose components are independent
+// gamma draws normalized by their sum. When any concentration is below 1 the
+// normalization is done from logs to avoid an all-zero vector.
+class Dirichlet {
+   public:
+    explicit Dirichlet(const std::vector<double> &alpha);
+
+    // write one sample of size() components to out
+    template <typename RNG>
+    void operator()(RNG &rand, double *out) const;
+
+    // fill [out, out+n*size()) with n samples using rand
+    template <typename RNG>
+    void Fill(RNG &rand, double *out, size_t n) const;
+
+    size_t size() const { return gamma_.size(); }
+
+   private:
+    std::vector<Gamma> gamma_;
+    bool logs_{false};
+};
+
+inline Dirichlet::Dirichlet(const std::vector<double> &alpha) {
+    assert(!alpha.empty());
+    gamma_.reserve(alpha.size());
+    for(auto &&a : alpha) {
+        gamma_.emplace_back(a);
+        logs_ = logs_ || a < 1.0;
+    }
+}
+
+template <typename RNG>
+inline void Dirichlet::operator()(RNG &rand, double *out) const {
+    RACUTILS_RANDOM_STAT(DIRICHLET_CALLS);
+    RACUTILS_RANDOM_STAT_DRAWS(DIRICHLET_DRAWS);
+    const size_t sz = gamma_.size();
+    if(logs_) {
+        double m = -std::numeric_limits<double>::infinity();
+        for(size_t j = 0; j < sz; ++j) {
+            out[j] = gamma_[j].Log(rand);
+            m = std::max(m, out[j]);
+        }
+        for(size_t j = 0; j < sz; ++j) {
+            out[j] = std::exp(out[j] - m);
+        }
+    } else {
+        for(size_t j = 0; j < sz; ++j) {
+            out[j] = gamma_[j](rand);
+        }
+    }
+    double sum = std::accumulate(out, out + sz, 0.0);
+    for(size_t j = 0; j < sz; ++j) {
+        out[j] /= sum;
+    }
+}
+
+template <typename RNG>
+inline void Dirichlet::Fill(RNG &rand, double *out, size_t n) const {
+    for(size_t i = 0; i < n; ++i) {
+        operator()(rand, out + i * gamma_.size());
+    }
+}
+
+// true with probability p. The top 53 bits of a draw are compared against
+// ceil(p*2^53), which gives the same result as f53() < p without a
+// conversion to floating point.
+class Bernoulli {
+   public:
+    constexpr explicit Bernoulli(double p) : p_{p}, threshold_{Threshold(p)} { assert(0.0 <= p && p <= 1.0); }
+
+    template <typename RNG>
+    bool operator()(RNG &rand) const {
+        RACUTILS_RANDOM_STAT(BERNOULLI_CALLS);
+        RACUTILS_RANDOM_STAT(BERNOULLI_DRAWS);
+        return Get(rand());
+    }
+
+    constexpr bool Get(uint64_t u) const { return (u >> 11) < threshold_; }
+
+    constexpr double p() const { return p_; }
+    constexpr uint64_t threshold() const { return threshold_; }
+
+   private:
+    // ceil(p*2^53); the product is exact
+    static constexpr uint64_t Threshold(double p) {
+        double x = p * 0x1p53;
+        auto t = static_cast<uint64_t>(x);
+        return (static_cast<double>(t) < x) ? t + 1 : t;
+    }
+
+    double p_;
+    uint64_t threshold_;
+};
+
+// number of failures before the first success of Bernoulli(p) trials,
+// floor(E/-log1p(-p)) for E exponential. Values beyond 2^64 saturate.
+class Geometric {
+   public:
+    explicit Geometric(double p) : p_{p}, scale_{-1.0 / std::log1p(-p)} { assert(0.0 < p && p <= 1.0); }
+
+    template <typename RNG>
+    uint64_t operator()(RNG &rand) const {
+        RACUTILS_RANDOM_STAT(GEOMETRIC_CALLS);
+        RACUTILS_RANDOM_STAT_DRAWS(GEOMETRIC_DRAWS);
+        double x = std::floor(rand.exp() * scale_);
+        return (x < 0x1p64) ? static_cast<uint64_t>(x) : UINT64_MAX;
+    }
+
+    // fill [out, out+n) with samples using rand
+    template <typename RNG>
+    void Fill(RNG &rand, uint64_t *out, size_t n) const {
+        for(size_t i = 0; i < n; ++i) {
+            out[i] = operator()(rand);
+        }
+    }
+
+    double p() const { return p_; }
+
+   private:
+    double p_;
+    double scale_;
+};
+
+// The indices of the successes among n Bernoulli(p) trials, in increasing
+// order. Each success costs one geometric skip, so sparse trials are visited
+// in time proportional to the number of successes.
+//     for(uint64_t i : BernoulliSuccesses(rand, p, n)) { ... }
+template <typename RNG>
+class BernoulliSuccesses {
+   public:
+    BernoulliSuccesses(RNG &rand, double p, uint64_t n) : rand_{&rand}, n_{n}, p_{p}, skip_{p > 0.0 ? p : 1.0} {
+        assert(0.0 <= p && p <= 1.0);
+    }
+
+    class iterator {
+       public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = uint64_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const uint64_t *;
+        using reference = const uint64_t &;
+
+        iterator() = default;
+
+        reference operator*() const { return pos_; }
+        iterator &operator++() {
+            pos_ = owner_->Next(pos_ + 1);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const iterator &x, const iterator &y) { return x.pos_ == y.pos_; }
+        friend bool operator!=(const iterator &x, const iterator &y) { return !(x == y); }
+
+       private:
+        friend class BernoulliSuccesses;
+        iterator(const BernoulliSuccesses *owner, uint64_t pos) : owner_{owner}, pos_{pos} {}
+
+        const BernoulliSuccesses *owner_{nullptr};
+        uint64_t pos_{0};
+    };
+
+    // The first call draws the first success; the range is single pass.
+    iterator begin() const { return iterator{this, Next(0)}; }
+    iterator end() const { return iterator{this, n_}; }
+
+   private:
+    // the first success at or after trial i, or n if there is none
+    uint64_t Next(uint64_t i) const {
+        if(i >= n_ || p_ == 0.0) {
+            return n_;
+        }
+        uint64_t k = skip_(*rand_);
+        return (k < n_ - i) ? i + k : n_;
+    }
+
+    RNG *rand_;
+    uint64_t n_;
+    double p_;
+    Geometric skip_;
+};
+
+// Think about using https://gist.github.com/imneme/540829265469e673d045
+// https://www.pcg-random.org/posts/simple-portable-cpp-seed-entropy.html
+// https://www.pcg-random.org/posts/cpps-random_device.html
+
+namespace details {
+// Multilinear hash (https://arxiv.org/pdf/1202.4961.pdf)
+// Hash is based on a sequence of 64-bit numbers generated by Weyl sequence
+// Multilinear hash is (m_0 + sum(m_i*u_i) mod 2^64) / 2^32
+// m = buffer of 64-bit unsigned random values
+// u = 32-bit input values that are being hashed
+template <uint64_t INC, uint64_t INIT>
+struct hash_impl_t {
+    template <typename In1, typename In2, typename Out1, typename Out2>
+    void operator()(In1 it1, In2 it2, Out1 itA, Out2 itB) {
+        uint64_t w = INIT;
+        auto next_num = [&w]() {
+            w += INC;
+            return w;
+        };
+
+        for(auto out = itA; out != itB; ++out) {
+            // hash input
+            uint64_t sum = next_num();
+            for(auto it = it1; it != it2; ++it) {
+                uint32_t u = *it;
+                sum += next_num() * u;
+            }
+            // If input ends in a zero, the hash is not unique.
+            // Add a final value to ensure that this doesn't happen.
+            sum += next_num() * 1;
+            // final value
+            *out = static_cast<uint32_t>(sum >> 32);
+        }
+    }
+};
+
+using hash_implA = hash_impl_t<0x9e3779b97f4a7c15ULL, 0x3423da0b87484307ULL>;
+using hash_implB = hash_impl_t<0x9e3779b97f4a7c15ULL, 0xdf8b06c40fa44478ULL>;
+
+// Coefficients of hash_impl_t for a fixed number of inputs and outputs.
+// m[i][j] multiplies input i-1 of output j; row 0 is the constant term and
+// row inputs+1 is the final term. Storing them by input lets the hash be
+// evaluated with the inner loop running across outputs.
+template <uint64_t INC, uint64_t INIT, size_t inputs, size_t outputs>
+struct hash_coeffs_t {
+    uint64_t m[inputs + 2][outputs];
+
+    hash_coeffs_t() {
+        for(size_t j = 0; j < outputs; ++j) {
+            for(size_t i = 0; i < inputs + 2; ++i) {
+                m[i][j] = INIT + (j * (inputs + 2) + i + 1) * INC;
+            }
+        }
+    }
+
+    // sum[j] += m[i][j] * u for every output j
+    void Accumulate(size_t i, uint32_t u, uint64_t *sum) const {
+        for(size_t j = 0; j < outputs; ++j) {
+            sum[j] += m[i][j] * u;
+        }
+    }
+};
+
+template <size_t inputs, size_t outputs>
+using hash_coeffsA = hash_coeffs_t<0x9e3779b97f4a7c15ULL, 0x3423da0b87484307ULL, inputs, outputs>;
+template <size_t inputs, size_t outputs>
+using hash_coeffsB = hash_coeffs_t<0x9e3779b97f4a7c15ULL, 0xdf8b06c40fa44478ULL, inputs, outputs>;
+}  // namespace details
+
+// SeedSeq is a finite entropy seed sequence.
+// Inspiration: https://www.pcg-random.org/posts/developing-a-seed_seq-alternative.html
+template <size_t count>
+class SeedSeq {
+   public:
+    using result_type = uint32_t;
+
+   private:
+    std::array<result_type, count> state_;
+
+   public:
+    template <typename It1, typename It2>
+    SeedSeq(It1 begin, It2 end) {
+        Seed(begin, end);
+    }
+
+    template <typename T>
+    SeedSeq(std::initializer_list<T> init) {
+        Seed(init.begin(), init.end());
+    }
+
+    // Generates an internal state based on provided seeds
+    template <typename It1, typename It2>
+    void Seed(It1 begin, It2 end) {
+        details::hash_implA hash;
+        hash(begin, end, state_.begin(), state_.end());
+    }
+
+    // Generates an external state based on the internal state
+    template <typename It1, typename It2>
+    void Generate(It1 begin, It2 end) const {
+        details::hash_implB hash;
+        hash(state_.begin(), state_.end(), begin, end);
+    }
+
+    // Derives an independent seed sequence for id, e.g. one per agent.
+    // Equivalent to seeding with the internal state followed by the low and
+    // high words of id.
+    SeedSeq Spawn(uint64_t id) const {
+        std::array<result_type, count + 2> words;
+        std::copy(state_.begin(), state_.end(), words.begin());
+        words[count] = static_cast<result_type>(id);
+        words[count + 1] = static_cast<result_type>(id >> 32);
+        return SeedSeq(words.begin(), words.end());
+    }
+
+    // Bulk form of Spawn(ids[k]).Generate(out[k].begin(), out[k].end()) for
+    // k in [0, n), where T is a std::array such as an engine's seed_type.
+    // The result is bit-identical, but the contribution of the internal
+    // state is only hashed once and the rest runs across outputs.
+    template <typename T>
+    void GenerateBatch(const uint64_t *ids, size_t n, T *out) const;
+};
+
+template <size_t count>
+template <typename T>
+inline void SeedSeq<count>::GenerateBatch(const uint64_t *ids, size_t n, T *out) const {
+    constexpr size_t outputs = std::tuple_size<T>::value;
+    constexpr size_t block = 64;
+    const details::hash_coeffsA<count + 2, count> spawn;
+    const details::hash_coeffsB<count, outputs> generate;
+
+    // hash the shared prefix of Spawn's input once
+    uint64_t prefix[count];
+    for(size_t j = 0; j < count; ++j) {
+        prefix[j] = spawn.m[0][j] + spawn.m[count + 3][j];
+        for(size_t i = 0; i < count; ++i) {
+            prefix[j] += spawn.m[i + 1][j] * state_[i];
+        }
+    }
+
+    // ids are processed in blocks with the innermost loop running across
+    // the block, so each coefficient is broadcast into a vector multiply
+    uint32_t child[count][block] = {};
+    uint64_t sum[block];
+    for(size_t k = 0; k < n; k += block) {
+        const size_t m = std::min(block, n - k);
+        for(size_t i = 0; i < count; ++i) {
+            const uint64_t mlo = spawn.m[count + 1][i], mhi = spawn.m[count + 2][i];
+            for(size_t b = 0; b < m; ++b) {
+                const uint64_t id = ids[k + b];
+                const uint64_t h = prefix[i] + mlo * static_cast<uint32_t>(id) + mhi * static_cast<uint32_t>(id >> 32);
+                child[i][b] = static_cast<uint32_t>(h >> 32);
+            }
+        }
+        for(size_t j = 0; j < outputs; ++j) {
+            const uint64_t base = generate.m[0][j] + generate.m[count + 1][j];
+            for(size_t b = 0; b < block; ++b) {
+                sum[b] = base;
+            }
+            for(size_t i = 0; i < count; ++i) {
+                const uint64_t c = generate.m[i + 1][j];
+                for(size_t b = 0; b < block; ++b) {
+                    sum[b] += c * child[i][b];
+                }
+            }
+            for(size_t b = 0; b < m; ++b) {
+                out[k + b][j] = static_cast<uint32_t>(sum[b] >> 32);
+            }
+        }
+    }
+}
+
+using SeedSeq256 = SeedSeq<8>;
+
+template <typename Engine>
+inline void BasicRandom<Engine>::Seed(uint32_t s) {
+    SeedSeq256 ss({s});
+    Seed(ss);
+}
+
+template <typename Engine>
+template <size_t count>
+inline void BasicRandom<Engine>::Seed(const SeedSeq<count> &ss) {
+    seed_type seed;
+    ss.Generate(seed.begin(), seed.end());
+    Seed(seed);
+}
+
+namespace details {
+constexpr char BASE58_ALPHABET[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+inline std::string base58_encode(uint32_t u) {
+    std::string buffer(6, BASE58_ALPHABET[0]);
+    for(int i = 0; i < 6 && u != 0; ++i) {
+        buffer[5 - i] = BASE58_ALPHABET[u % 58];
+        u = u / 58;
+    }
+    return buffer;
+}
+
+// parses the 6 characters at str written by base58_encode
+inline bool base58_decode(const char *str, uint32_t *u) {
+    uint64_t value = 0;
+    for(int i = 0; i < 6; ++i) {
+        const char *pos = str[i] == '\0' ? nullptr : std::strchr(BASE58_ALPHABET, str[i]);
+        if(pos == nullptr) {
+            return false;
+        }
+        value = value * 58 + static_cast<uint64_t>(pos - BASE58_ALPHABET);
+    }
+    if(value > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+    *u = static_cast<uint32_t>(value);
+    return true;
+}
+}  // namespace details
+
+template <size_t COUNT>
+std::string encode_seed(const std::array<uint32_t, COUNT> &seed) {
+    if(seed.empty()) {
+        return {};
+    }
+    std::string str = details::base58_encode(seed[0]);
+    for(size_t i = 1; i < seed.size(); ++i) {
+        str += "-";
+        str += details::base58_encode(seed[i]);
+    }
+    return str;
+}
+
+// parses a seed written by encode_seed, or returns false if str is not a seed
+// of COUNT words
+template <size_t COUNT>
+bool decode_seed(const std::string &str, std::array<uint32_t, COUNT> *seed) {
+    if(str.size() != (COUNT == 0 ? 0 : 7 * COUNT - 1)) {
+        return false;
+    }
+    for(size_t i = 0; i < COUNT; ++i) {
+        if((i > 0 && str[7 * i - 1] != '-') || !details::base58_decode(str.data() + 7 * i, &(*seed)[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace details {
+static constexpr uint32_t fnv(uint32_t hash, const char *pos) {
+    return *pos == '\0' ? hash : fnv((hash * 16777619U) ^ *pos, pos + 1);
+}
+
+template <typename T>
+static uint64_t hash(T &&value) {
     auto h =
         std::hash<typename std::remove_reference<typename std::remove_cv<T>::type>::type>{}(std::forward<T>(value));
     return static_cast<uint64_t>(h);
 }
 
 template <typename T>
-static uint32_t crushto32(T &&value) {
-    uint64_t u = details::hash(value);
-    // Multilinear hash
-    uint64_t result = 0x80e25f91f5ba47eaULL;
-    result += 0x6db4dd6c7a89963cULL * static_cast<uint32_t>(u);
-    result += 0xd35f3cdd31f49ad8ULL * static_cast<uint32_t>(u >> 32);
-    return static_cast<uint32_t>(result >> 32);
+static uint32_t crushto32(T &&value) {
+    uint64_t u = details::hash(value);
+    // Multilinear hash
+    uint64_t result = 0x80e25f91f5ba47eaULL;
+    result += 0x6db4dd6c7a89963cULL * static_cast<uint32_t>(u);
+    result += 0xd35f3cdd31f49ad8ULL * static_cast<uint32_t>(u >> 32);
+    return static_cast<uint32_t>(result >> 32);
+};
+
+// 64 bits of system-wide entropy, read from std::random_device once per process
+inline uint64_t process_entropy() {
+    static const uint64_t entropy = [] {
+        std::random_device rd;
+        uint64_t hi = rd();
+        return (hi << 32) | rd();
+    }();
+    return entropy;
+}
+
+// a process-wide counter that is different for every call
+inline uint64_t seed_counter() {
+    static std::atomic<uint64_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+// the id of the calling process, which tells apart the children of a fork
+// that share the cached entropy and the counter
+inline uint64_t process_id() {
+#if defined(_WIN64) || defined(_WIN32)
+    return static_cast<uint64_t>(_getpid());
+#else
+    return static_cast<uint64_t>(getpid());
+#endif
+}
+
+// a cheap, high-resolution timestamp
+inline uint64_t cycle_counter() {
+#if defined(__has_builtin) && __has_builtin(__builtin_readcyclecounter)
+    return __builtin_readcyclecounter();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+}  // namespace details
+
+// Returns a seed sequence that is different for every call, without locks
+// or allocation. It combines entropy read once per process, a process-wide
+// atomic counter, the process id, the cycle counter, and a stack address.
+inline SeedSeq256 auto_seed_seq() {
+    // Constant that changes every time we compile the code
+    constexpr uint32_t compile_stamp = details::fnv(2166136261U, __DATE__ __TIME__ __FILE__);
+
+    uint64_t entropy = details::process_entropy();
+    uint64_t count = details::seed_counter();
+    uint64_t pid = details::process_id();
+    uint64_t cycles = details::cycle_counter();
+    auto stack = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&count));
+
+    return SeedSeq256({compile_stamp, static_cast<uint32_t>(entropy), static_cast<uint32_t>(entropy >> 32),
+                       static_cast<uint32_t>(count), static_cast<uint32_t>(count >> 32),
+                       static_cast<uint32_t>(pid), static_cast<uint32_t>(pid >> 32),
+                       static_cast<uint32_t>(cycles), static_cast<uint32_t>(cycles >> 32),
+                       static_cast<uint32_t>(stack), static_cast<uint32_t>(stack >> 32)});
+}
+
+// Like auto_seed_seq, but also gathers heap and stack addresses, clocks,
+// function addresses, the thread id and the process id on every call.
+// It is much slower, but does not depend on entropy cached in the process.
+// Based on ideas from https://www.pcg-random.org/posts/simple-portable-cpp-seed-entropy.html
+// Based on code from https://gist.github.com/imneme/540829265469e673d045
+inline SeedSeq256 auto_seed_seq_full() {
+    using details::crushto32;
+
+    // Constant that changes every time we compile the code
+    constexpr uint32_t compile_stamp = details::fnv(2166136261U, __DATE__ __TIME__ __FILE__);
+
+    // 32-bits of system-wide entropy, made unique for every call
+    auto random_int = static_cast<uint32_t>(details::process_entropy() + 0xedf19156 * details::seed_counter());
+
+    // heap randomness
+    void *malloc_addr = malloc(sizeof(int));  // NOLINT
+    free(malloc_addr);                        // NOLINT
+    auto heap = crushto32(malloc_addr);
+    auto stack = crushto32(&malloc_addr);
+
+    // High-resolution time information
+    auto hitime = crushto32(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    // The address of the couple of functions.
+    auto time_func = crushto32(&std::chrono::high_resolution_clock::now);
+    auto exit_func = crushto32(&_Exit);
+    auto self_func = crushto32(&auto_seed_seq_full);
+
+    // Thread ID
+    auto thread_id = crushto32(std::this_thread::get_id());
+
+    // PID
+    auto pid = crushto32(details::process_id());
+
+    auto cpu = crushto32(details::cycle_counter());
+
+    return SeedSeq256(
+        {compile_stamp, random_int, heap, stack, hitime, time_func, exit_func, self_func, thread_id, pid, cpu});
+}
+
+// Checkpoints store the states of an array of engines in a packed, versioned
+// binary layout. All fields are little-endian 64-bit words. The header is
+//   "RACRNGCK" magic, version, engine id, words per engine, engine count,
+// padded with zeros to 64 bytes, and is followed by the state words of each
+// engine. On little-endian hosts the
+// states have the same layout as an array of engines, so a checkpoint that
+// has been read or memory-mapped can be used in place with checkpoint_view.
+// Functions report errors by returning false or nullptr.
+namespace details {
+constexpr char CHECKPOINT_MAGIC[8] = {'R', 'A', 'C', 'R', 'N', 'G', 'C', 'K'};
+constexpr uint64_t CHECKPOINT_VERSION = 1;
+constexpr size_t CHECKPOINT_HEADER_WORDS = 8;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+constexpr bool HOST_IS_LITTLE_ENDIAN = false;
+#else
+constexpr bool HOST_IS_LITTLE_ENDIAN = true;
+#endif
+
+inline void store_le64(unsigned char *p, uint64_t u) {
+    if(!HOST_IS_LITTLE_ENDIAN) {
+        u = __builtin_bswap64(u);
+    }
+    std::memcpy(p, &u, sizeof(u));
+}
+
+inline uint64_t load_le64(const unsigned char *p) {
+    uint64_t u;
+    std::memcpy(&u, p, sizeof(u));
+    return HOST_IS_LITTLE_ENDIAN ? u : __builtin_bswap64(u);
+}
+
+// check that p holds a valid checkpoint header for Engine and store the engine count
+template <typename Engine>
+bool checkpoint_header(const unsigned char *p, size_t size, uint64_t *count) {
+    if(size < 8 * CHECKPOINT_HEADER_WORDS || std::memcmp(p, CHECKPOINT_MAGIC, 8) != 0 ||
+       load_le64(p + 8) != CHECKPOINT_VERSION || load_le64(p + 16) != Engine::ENGINE_ID ||
+       load_le64(p + 24) != Engine::STATE_WORDS) {
+        return false;
+    }
+    *count = load_le64(p + 32);
+    return *count <= (size / 8 - CHECKPOINT_HEADER_WORDS) / Engine::STATE_WORDS;
+}
+}  // namespace details
+
+// size in bytes of a checkpoint of n engines
+template <typename Engine>
+constexpr size_t checkpoint_size(size_t n) {
+    return 8 * (details::CHECKPOINT_HEADER_WORDS + n * Engine::STATE_WORDS);
+}
+
+// write the states of engines[0..n) to out, which holds size bytes
+// A checkpoint holds at least one engine, so n == 0 is an error.
+template <typename Engine>
+bool write_checkpoint(const Engine *engines, size_t n, void *out, size_t size) {
+    if(out == nullptr || n == 0 || size < checkpoint_size<Engine>(n)) {
+        return false;
+    }
+    auto *p = static_cast<unsigned char *>(out);
+    std::memcpy(p, details::CHECKPOINT_MAGIC, 8);
+    details::store_le64(p + 8, details::CHECKPOINT_VERSION);
+    details::store_le64(p + 16, Engine::ENGINE_ID);
+    details::store_le64(p + 24, Engine::STATE_WORDS);
+    details::store_le64(p + 32, n);
+    std::memset(p + 40, 0, 8 * details::CHECKPOINT_HEADER_WORDS - 40);
+    p += 8 * details::CHECKPOINT_HEADER_WORDS;
+    std::array<uint64_t, Engine::STATE_WORDS> w;
+    for(size_t i = 0; i < n; ++i) {
+        engines[i].GetStateWords(w.data());
+        for(auto &&u : w) {
+            details::store_le64(p, u);
+            p += 8;
+        }
+    }
+    return true;
+}
+
+// returns the number of engines stored in a checkpoint, or 0 if it is not
+// a valid checkpoint for Engine
+template <typename Engine>
+size_t checkpoint_count(const void *in, size_t size) {
+    uint64_t count = 0;
+    if(in == nullptr || !details::checkpoint_header<Engine>(static_cast<const unsigned char *>(in), size, &count)) {
+        return 0;
+    }
+    return count;
+}
+
+// restore engines[0..n) from a checkpoint of exactly n engines
+template <typename Engine>
+bool read_checkpoint(const void *in, size_t size, Engine *engines, size_t n) {
+    if(checkpoint_count<Engine>(in, size) != n || n == 0) {
+        return false;
+    }
+    const auto *p = static_cast<const unsigned char *>(in) + 8 * details::CHECKPOINT_HEADER_WORDS;
+    std::array<uint64_t, Engine::STATE_WORDS> w;
+    for(size_t i = 0; i < n; ++i) {
+        for(auto &&u : w) {
+            u = details::load_le64(p);
+            p += 8;
+        }
+        engines[i].SetStateWords(w.data());
+    }
+    return true;
+}
+
+// Use the states in a checkpoint in place, without copying. Returns a
+// pointer to the engines and stores their number in n, or returns nullptr
+// if the layout of the checkpoint does not match Engine on this host, e.g.
+// a big-endian host or a buffer that is not aligned for Engine.
+template <typename Engine>
+Engine *checkpoint_view(void *in, size_t size, size_t *n) {
+    static_assert(std::is_trivially_copyable<Engine>::value, "Engine must be trivially copyable.");
+    size_t count = checkpoint_count<Engine>(in, size);
+    auto *p = static_cast<unsigned char *>(in) + 8 * details::CHECKPOINT_HEADER_WORDS;
+    if(count == 0 || !details::HOST_IS_LITTLE_ENDIAN || sizeof(Engine) != 8 * Engine::STATE_WORDS ||
+       reinterpret_cast<uintptr_t>(p) % alignof(Engine) != 0) {
+        return nullptr;
+    }
+    *n = count;
+    return reinterpret_cast<Engine *>(p);
+}
+
+// Stream files record the output of an engine or a batch sampler so that a
+// run can be replayed. The first page is a header of little-endian words:
+//   "RACRNGST" magic, version, engine id, bytes per value, value count,
+//   stream, offset, seed length,
+// followed by the seed as text, e.g. from encode_seed. Stream and offset
+// describe where the recording starts: Discard(offset) applied to stream
+// stream of the engine seeded with seed. The values start at STREAM_FILE_DATA_OFFSET
+// in host layout, and files are memory-mapped for both writing and reading.
+// Only little-endian POSIX hosts are supported; functions return false or
+// nullptr on error.
+struct StreamFileInfo {
+    uint64_t engine_id{0};
+    uint64_t value_size{sizeof(uint64_t)};
+    uint64_t stream{0};
+    uint64_t offset{0};
+    std::string seed;
+};
+
+// describes a recording that starts offset draws into stream stream of
+// master. Seed(master.GetSeed()) must restore master: that holds at any
+// position for Lehmer64Fast and Xoshiro256StarStar, but only at the start of
+// stream 0 for Philox2x64. Record the generator set by stream_file_start.
+template <typename Engine>
+StreamFileInfo stream_file_info(const BasicRandom<Engine> &master, uint64_t stream = 0, uint64_t offset = 0) {
+    return {Engine::ENGINE_ID, sizeof(uint64_t), stream, offset, encode_seed(master.GetSeed())};
+}
+
+// sets rand to the position of the first recorded value from the header
+// alone, or returns false if the header does not describe a recording of Engine
+template <typename Engine>
+bool stream_file_start(const StreamFileInfo &info, BasicRandom<Engine> *rand) {
+    typename Engine::seed_type seed;
+    if(info.engine_id != Engine::ENGINE_ID || info.value_size != sizeof(uint64_t) || !decode_seed(info.seed, &seed)) {
+        return false;
+    }
+    BasicRandom<Engine> master;
+    master.Seed(seed);
+    *rand = master.Stream(info.stream).Jump(info.offset);
+    return true;
+}
+
+namespace details {
+constexpr char STREAM_FILE_MAGIC[8] = {'R', 'A', 'C', 'R', 'N', 'G', 'S', 'T'};
+constexpr uint64_t STREAM_FILE_VERSION = 1;
+constexpr size_t STREAM_FILE_HEADER_WORDS = 8;
+}  // namespace details
+
+constexpr size_t STREAM_FILE_DATA_OFFSET = 4096;
+
+// ReplayEngine returns the values of a recording, e.g. from
+// StreamFileReader, without copying them. Seed rewinds to the first value.
+// Reading or discarding past the end throws std::out_of_range, so a replay
+// never silently reuses or invents values.
+class ReplayEngine {
+   public:
+    using result_type = uint64_t;
+    using seed_type = std::array<uint32_t, 0>;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    ReplayEngine() = default;
+    ReplayEngine(const uint64_t *data, size_t n) : data_{data}, pos_{data}, end_{data + n} {}
+
+    void Seed(seed_type /*unused*/) { pos_ = data_; }
+    seed_type GetSeed() const { return {}; }
+
+    result_type operator()() {
+        Require(1);
+        return *pos_++;
+    }
+
+    // nothing is written if fewer than n values are left
+    void Fill(uint64_t *out, size_t n) {
+        Require(n);
+        if(n > 0) {
+            std::memcpy(out, pos_, n * sizeof(uint64_t));
+            pos_ += n;
+        }
+    }
+
+    void Discard(size_t count) {
+        Require(count);
+        pos_ += count;
+    }
+
+    // number of values left
+    size_t remaining() const { return end_ - pos_; }
+
+   private:
+    void Require(size_t n) const {
+        if(n > remaining()) {
+            throw std::out_of_range("ReplayEngine: the recording is exhausted");
+        }
+    }
+
+    const uint64_t *data_{nullptr};
+    const uint64_t *pos_{nullptr};
+    const uint64_t *end_{nullptr};
+};
+
+using ReplayRandom = BasicRandom<ReplayEngine>;
+
+#if !defined(_WIN64) && !defined(_WIN32)
+// StreamFileWriter appends values to a memory-mapped stream file. The file
+// grows in chunks of GROW_SIZE bytes, and batch samplers write directly into
+// the mapping.
+class StreamFileWriter {
+   public:
+    static constexpr size_t GROW_SIZE = size_t{1} << 24;
+
+    StreamFileWriter() = default;
+    StreamFileWriter(const StreamFileWriter &) = delete;
+    StreamFileWriter &operator=(const StreamFileWriter &) = delete;
+    ~StreamFileWriter() { Close(); }
+
+    // create or truncate path and write the header
+    bool Open(const char *path, const StreamFileInfo &info);
+
+    // append n values made by fill(out, n), where out points into the file
+    template <typename T, typename F>
+    bool Generate(size_t n, F &&fill) {
+        T *out = static_cast<T *>(Reserve(sizeof(T), n));
+        if(out == nullptr) {
+            return false;
+        }
+        fill(out, n);
+        count_ += n;
+        return true;
+    }
+
+    // append values[0..n)
+    template <typename T>
+    bool Write(const T *values, size_t n) {
+        return Generate<T>(n, [values](T *out, size_t m) { std::copy(values, values + m, out); });
+    }
+
+    // append the next n values of rand
+    template <typename RNG>
+    bool Record(RNG &rand, size_t n) {
+        return Generate<uint64_t>(n, [&rand](uint64_t *out, size_t m) { rand.fill_u64(out, m); });
+    }
+
+    // store the value count, trim the file to its final size, and unmap it
+    bool Close();
+
+    bool is_open() const { return fd_ >= 0; }
+    uint64_t count() const { return count_; }
+
+   private:
+    void *Reserve(size_t value_size, size_t n);
+    bool Map(size_t size);
+
+    int fd_{-1};
+    unsigned char *map_{nullptr};
+    size_t capacity_{0};
+    uint64_t value_size_{0};
+    uint64_t count_{0};
+};
+
+inline bool StreamFileWriter::Open(const char *path, const StreamFileInfo &info) {
+    Close();
+    if(!details::HOST_IS_LITTLE_ENDIAN || info.value_size == 0 ||
+       info.seed.size() > STREAM_FILE_DATA_OFFSET - 8 * details::STREAM_FILE_HEADER_WORDS) {
+        return false;
+    }
+    value_size_ = info.value_size;
+    count_ = 0;
+    fd_ = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd_ < 0 || !Map(STREAM_FILE_DATA_OFFSET + GROW_SIZE)) {
+        Close();
+        return false;
+    }
+    unsigned char *p = map_;
+    std::memcpy(p, details::STREAM_FILE_MAGIC, 8);
+    details::store_le64(p + 8, details::STREAM_FILE_VERSION);
+    details::store_le64(p + 16, info.engine_id);
+    details::store_le64(p + 24, info.value_size);
+    details::store_le64(p + 32, 0);
+    details::store_le64(p + 40, info.stream);
+    details::store_le64(p + 48, info.offset);
+    details::store_le64(p + 56, info.seed.size());
+    std::memcpy(p + 8 * details::STREAM_FILE_HEADER_WORDS, info.seed.data(), info.seed.size());
+    return true;
+}
+
+// resize the file to size bytes and map all of it
+inline bool StreamFileWriter::Map(size_t size) {
+    if(map_ != nullptr) {
+        ::munmap(map_, capacity_);
+        map_ = nullptr;
+    }
+    if(::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+        return false;
+    }
+    void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if(p == MAP_FAILED) {
+        return false;
+    }
+    map_ = static_cast<unsigned char *>(p);
+    capacity_ = size;
+    return true;
+}
+
+// returns space for n more values, growing the file if needed
+inline void *StreamFileWriter::Reserve(size_t value_size, size_t n) {
+    if(fd_ < 0 || value_size != value_size_) {
+        return nullptr;
+    }
+    size_t used = STREAM_FILE_DATA_OFFSET + count_ * value_size_;
+    size_t need = used + n * value_size_;
+    if(need > capacity_) {
+        size_t size = std::max(need, capacity_ + std::max(capacity_ / 2, GROW_SIZE));
+        size = (size + GROW_SIZE - 1) / GROW_SIZE * GROW_SIZE;
+        if(!Map(size)) {
+            Close();
+            return nullptr;
+        }
+    }
+    return map_ + used;
+}
+
+inline bool StreamFileWriter::Close() {
+    if(fd_ < 0) {
+        return false;
+    }
+    bool ok = true;
+    if(map_ != nullptr) {
+        details::store_le64(map_ + 32, count_);
+        ok = ::munmap(map_, capacity_) == 0;
+        map_ = nullptr;
+    } else {
+        // a failed grow unmapped the file, but the values written so far are in it
+        unsigned char count[8];
+        details::store_le64(count, count_);
+        ok = ::pwrite(fd_, count, sizeof(count), 32) == static_cast<ssize_t>(sizeof(count));
+    }
+    ok = ok && ::ftruncate(fd_, static_cast<off_t>(STREAM_FILE_DATA_OFFSET + count_ * value_size_)) == 0;
+    ok = (::close(fd_) == 0) && ok;
+    fd_ = -1;
+    capacity_ = 0;
+    return ok;
+}
+
+// StreamFileReader maps a stream file read-only for zero-copy access.
+class StreamFileReader {
+   public:
+    StreamFileReader() = default;
+    StreamFileReader(const StreamFileReader &) = delete;
+    StreamFileReader &operator=(const StreamFileReader &) = delete;
+    ~StreamFileReader() { Close(); }
+
+    // map path and check its header
+    bool Open(const char *path);
+    void Close();
+
+    const StreamFileInfo &info() const { return info_; }
+    uint64_t size() const { return count_; }
+
+    // the recorded values, or nullptr if T does not match the value size
+    template <typename T>
+    const T *data() const {
+        return (map_ != nullptr && sizeof(T) == info_.value_size)
+                   ? reinterpret_cast<const T *>(map_ + STREAM_FILE_DATA_OFFSET)
+                   : nullptr;
+    }
+
+    // a generator that replays the recorded engine output
+    // Throws std::invalid_argument if no file is open or it does not hold uint64_t values.
+    ReplayRandom Replay() const {
+        if(data<uint64_t>() == nullptr) {
+            throw std::invalid_argument("StreamFileReader: not a recording of uint64_t values");
+        }
+        return ReplayRandom{data<uint64_t>(), count_};
+    }
+
+   private:
+    const unsigned char *map_{nullptr};
+    size_t size_{0};
+    uint64_t count_{0};
+    StreamFileInfo info_;
+};
+
+inline bool StreamFileReader::Open(const char *path) {
+    Close();
+    int fd = ::open(path, O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+    struct stat st;
+    void *p = MAP_FAILED;
+    if(::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= STREAM_FILE_DATA_OFFSET) {
+        p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if(p == MAP_FAILED) {
+        return false;
+    }
+    map_ = static_cast<const unsigned char *>(p);
+    size_ = st.st_size;
+
+    const unsigned char *h = map_;
+    uint64_t seed_size = details::load_le64(h + 56);
+    info_.engine_id = details::load_le64(h + 16);
+    info_.value_size = details::load_le64(h + 24);
+    count_ = details::load_le64(h + 32);
+    info_.stream = details::load_le64(h + 40);
+    info_.offset = details::load_le64(h + 48);
+    if(!details::HOST_IS_LITTLE_ENDIAN || std::memcmp(h, details::STREAM_FILE_MAGIC, 8) != 0 ||
+       details::load_le64(h + 8) != details::STREAM_FILE_VERSION || info_.value_size == 0 ||
+       seed_size > STREAM_FILE_DATA_OFFSET - 8 * details::STREAM_FILE_HEADER_WORDS ||
+       count_ > (size_ - STREAM_FILE_DATA_OFFSET) / info_.value_size) {
+        Close();
+        return false;
+    }
+    info_.seed.assign(reinterpret_cast<const char *>(h + 8 * details::STREAM_FILE_HEADER_WORDS), seed_size);
+    return true;
+}
+
+inline void StreamFileReader::Close() {
+    if(map_ != nullptr) {
+        ::munmap(const_cast<unsigned char *>(map_), size_);
+    }
+    map_ = nullptr;
+    size_ = 0;
+    count_ = 0;
+    info_ = StreamFileInfo{};
+}
+#endif
+
+namespace details {
+// allocator that aligns storage to cache lines
+template <typename T>
+struct CacheAlignedAllocator {
+    using value_type = T;
+
+    CacheAlignedAllocator() = default;
+    template <typename U>
+    explicit CacheAlignedAllocator(const CacheAlignedAllocator<U> & /*unused*/) {}
+
+    template <typename U>
+    struct rebind {
+        using other = CacheAlignedAllocator<U>;
+    };
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t{CACHE_LINE_SIZE}));
+    }
+    void deallocate(T *p, size_t /*unused*/) { ::operator delete(p, std::align_val_t{CACHE_LINE_SIZE}); }
+
+    template <typename U>
+    bool operator==(const CacheAlignedAllocator<U> & /*unused*/) const {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const CacheAlignedAllocator<U> & /*unused*/) const {
+        return false;
+    }
 };
+
+// block size and prefetch distance used by batch samplers of tables
+constexpr size_t SAMPLE_BLOCK_SIZE = 256;
+constexpr size_t SAMPLE_PREFETCH_DISTANCE = 32;
+
+// round x up to a power of two, y=2^k, and return {y, k}
+template <typename T>
+constexpr std::pair<T, int> alias_round_up(T x) {
+    T y = static_cast<T>(2);
+    int k = 1;
+    for(; y < x; y *= 2, ++k) {
+        /*noop*/;
+    }
+    return std::make_pair(y, k);
+}
+
+// Pair the weights w[0..n) against the mean d. set_entry(i, p, a) is called to
+// store the probability p, scaled to 2^32, and the alias a of entry i.
+// rest(i) is called for every entry that could not be paired, and w[i] is left
+// holding its unpaired weight. w is modified during construction.
+template <typename Set, typename Rest>
+constexpr void alias_table_sweep_range(double *w, size_t sz, double d, Set &&set_entry, Rest &&rest) {
+    // find first large and small values
+    //     g: current large value index
+    //     m: current small value index
+    //    mm: next possible small value index
+    size_t g = 0, m = 0;
+    for(; g < sz && w[g] < d; ++g) {
+        /*noop*/;
+    }
+    for(; m < sz && w[m] >= d; ++m) {
+        /*noop*/;
+    }
+    size_t mm = m + 1;
+
+    // construct table
+    while(g < sz && m < sz) {
+        assert(w[m] < d);
+        set_entry(m, static_cast<uint32_t>(4294967296.0 / d * w[m]), g);
+        w[g] = (w[g] + w[m]) - d;
+        if(w[g] >= d || mm <= g) {
+            for(m = mm; m < sz && w[m] >= d; ++m) {
+                /*noop*/;
+            }
+            mm = m + 1;
+        } else {
+            m = g;
+        }
+        for(; g < sz && w[g] < d; ++g) {
+            /*noop*/;
+        }
+    }
+    // if we stopped early report the rest
+    if(g < sz) {
+        rest(g);
+        for(g = g + 1; g < sz; ++g) {
+            if(w[g] < d) continue;
+            rest(g);
+        }
+    }
+    // if we stopped early report the rest
+    if(m < sz) {
+        rest(m);
+        for(m = mm; m < sz; ++m) {
+            if(w[m] > d) continue;
+            rest(m);
+        }
+    }
+}
+
+// Construct an alias table from the weights in v.
+// set_entry(i, p, a) is called to store the probability p, scaled to 2^32,
+// and the alias a of entry i. v is modified during construction.
+template <typename Set>
+void alias_table_sweep(std::vector<double> *v, Set &&set_entry) {
+    size_t sz = v->size();
+    // find scale for input vector
+    double d = std::accumulate(v->begin(), v->end(), 0.0) / sz;
+    alias_table_sweep_range(v->data(), sz, d, set_entry,
+                            [&](size_t i) { set_entry(i, std::numeric_limits<uint32_t>::max(), i); });
+}
+
+// Construct an alias table from the weights in v using num_tasks tasks run by
+// exec. The table is split into num_tasks contiguous chunks that are paired
+// independently. Entries that could not be paired inside their chunk are
+// gathered and paired in a final sequential sweep. For weights in random order
+// only O(sqrt(n)) entries are left per chunk; inputs sorted by weight
+// degrade gracefully to the cost of the sequential sweep.
+// set_entry must be safe to call concurrently for different i.
+template <typename Set, typename Executor>
+void alias_table_sweep(std::vector<double> *v, Set &&set_entry, size_t num_tasks, Executor &&exec) {
+    size_t sz = v->size();
+    num_tasks = std::max<size_t>(1, std::min(num_tasks, sz));
+    auto lo = [&](size_t t) { return t * (sz / num_tasks) + std::min(t, sz % num_tasks); };
+
+    // find scale for input vector
+    std::vector<double> sums(num_tasks, 0.0);
+    exec(num_tasks, [&](size_t t) { sums[t] = std::accumulate(v->begin() + lo(t), v->begin() + lo(t + 1), 0.0); });
+    double d = std::accumulate(sums.begin(), sums.end(), 0.0) / sz;
+
+    // pair each chunk and remember what is left over
+    std::vector<std::vector<size_t>> left(num_tasks);
+    exec(num_tasks, [&](size_t t) {
+        size_t b = lo(t);
+        alias_table_sweep_range(
+            v->data() + b, lo(t + 1) - b, d, [&](size_t i, uint32_t p, size_t a) { set_entry(b + i, p, b + a); },
+            [&](size_t i) { left[t].push_back(b + i); });
+    });
+
+    // pair the left overs
+    std::vector<size_t> index;
+    for(auto &&l : left) {
+        index.insert(index.end(), l.begin(), l.end());
+        std::vector<size_t>().swap(l);
+    }
+    std::vector<double> w(index.size());
+    for(size_t i = 0; i < index.size(); ++i) {
+        w[i] = (*v)[index[i]];
+    }
+    alias_table_sweep_range(
+        w.data(), w.size(), d, [&](size_t i, uint32_t p, size_t a) { set_entry(index[i], p, index[a]); },
+        [&](size_t i) { set_entry(index[i], std::numeric_limits<uint32_t>::max(), index[i]); });
+}
 }  // namespace details
 
-// Based on ideas from https://www.pcg-random.org/posts/simple-portable-cpp-seed-entropy.html
-// Based on code from https://gist.github.com/imneme/540829265469e673d045
-inline SeedSeq256 auto_seed_seq() {
-    using details::crushto32;
+// ThreadExecutor runs tasks 0..count-1 on up to num_threads threads,
+// including the calling thread, and returns when all of them are done.
+// Any callable that can be invoked as exec(count, task) can be used in its place.
+class ThreadExecutor {
+   public:
+    explicit ThreadExecutor(unsigned int num_threads = std::thread::hardware_concurrency())
+        : num_threads_{std::max(num_threads, 1U)} {}
+
+    template <typename Task>
+    void operator()(size_t count, Task &&task) const {
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            for(size_t t; (t = next.fetch_add(1, std::memory_order_relaxed)) < count;) {
+                task(t);
+            }
+        };
+        std::vector<std::thread> threads;
+        for(size_t i = 1; i < std::min<size_t>(num_threads_, count); ++i) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for(auto &&th : threads) {
+            th.join();
+        }
+    }
+
+    unsigned int num_threads() const { return num_threads_; }
+
+   private:
+    unsigned int num_threads_;
+};
+
+// CachePadded stores a value on its own cache lines, so that neighboring
+// values in an array can be modified by different threads without false sharing.
+template <typename T>
+struct alignas(details::CACHE_LINE_SIZE) CachePadded {
+    T value;
+
+    T &operator*() { return value; }
+    const T &operator*() const { return value; }
+    T *operator->() { return &value; }
+    const T *operator->() const { return &value; }
+};
+
+// BasicStreamPool hands out generators on non-overlapping substreams of one
+// master seed. Stream k always starts at the same position, so a task that
+// draws from Stream(task_id) produces the same values no matter which thread
+// runs it or how many threads there are.
+template <typename Engine>
+class BasicStreamPool {
+   public:
+    using random_type = BasicRandom<Engine>;
+    using padded_type = CachePadded<random_type>;
+    using streams_type = std::vector<padded_type, details::CacheAlignedAllocator<padded_type>>;
+
+    template <size_t count>
+    explicit BasicStreamPool(const SeedSeq<count> &ss) {
+        base_.Seed(ss);
+    }
+
+    // returns a generator at the start of stream k
+    random_type Stream(uint64_t k) const { return base_.Stream(k); }
+
+    // returns generators at the start of streams first to first+n-1, each on
+    // its own cache line
+    streams_type Streams(size_t n, uint64_t first = 0) const;
+
+    class LocalStream;
+
+    // returns a handle to a thread-local generator at the start of stream k
+    // Call it once at the start of each task and draw through the handle.
+    LocalStream Local(uint64_t k) const { return LocalStream{Stream(k)}; }
+
+   private:
+    // one generator per live LocalStream of the calling thread, innermost last
+    // A deque keeps the outer generators in place when an inner one is added.
+    static std::deque<padded_type> &LocalSlots() {
+        thread_local std::deque<padded_type> slots;
+        return slots;
+    }
+
+    random_type base_;
+};
+
+template <typename Engine>
+inline typename BasicStreamPool<Engine>::streams_type BasicStreamPool<Engine>::Streams(size_t n, uint64_t first) const {
+    streams_type streams(n);
+    for(size_t i = 0; i < n; ++i) {
+        streams[i].value = Stream(first + i);
+    }
+    return streams;
+}
+
+// LocalStream is a thread-local generator on one stream. Each live handle has
+// its own generator, so a nested task on the same thread, or another pool,
+// cannot move the stream an outer task is drawing from. Handles are released
+// in the reverse order of creation, as local variables are.
+template <typename Engine>
+class BasicStreamPool<Engine>::LocalStream {
+   public:
+    LocalStream(const LocalStream &) = delete;
+    LocalStream &operator=(const LocalStream &) = delete;
+    ~LocalStream() { LocalSlots().pop_back(); }
+
+    random_type &operator*() const { return slot_; }
+    random_type *operator->() const { return &slot_; }
+
+   private:
+    friend class BasicStreamPool;
+
+    explicit LocalStream(const random_type &rng) : slot_{LocalSlots().emplace_back(padded_type{rng}).value} {}
+
+    random_type &slot_;
+};
+
+using StreamPool = BasicStreamPool<details::RandomEngine>;
+
+// Samplers for fill that forward to the bulk functions of BasicRandom
+struct U64Sampler {
+    template <typename RNG>
+    uint64_t operator()(RNG &rand) const {
+        return rand.u64();
+    }
+    template <typename RNG>
+    void Fill(RNG &rand, uint64_t *out, size_t n) const {
+        rand.fill_u64(out, n);
+    }
+};
+
+struct F52Sampler {
+    template <typename RNG>
+    double operator()(RNG &rand) const {
+        return rand.f52();
+    }
+    template <typename RNG>
+    void Fill(RNG &rand, double *out, size_t n) const {
+        rand.f52_fill(out, n);
+    }
+};
+
+struct ExpSampler {
+    double mean{1.0};
+
+    template <typename RNG>
+    double operator()(RNG &rand) const {
+        return rand.exp(mean);
+    }
+    template <typename RNG>
+    void Fill(RNG &rand, double *out, size_t n) const {
+        rand.exp_fill(out, n, mean);
+    }
+};
+
+struct NormalSampler {
+    double mean{0.0};
+    double sd{1.0};
+
+    template <typename RNG>
+    double operator()(RNG &rand) const {
+        return rand.normal(mean, sd);
+    }
+    template <typename RNG>
+    void Fill(RNG &rand, double *out, size_t n) const {
+        rand.normal_fill(out, n, mean, sd);
+    }
+};
+
+namespace details {
+// number of values drawn from each substream by fill
+constexpr size_t FILL_BLOCK_SIZE = size_t{1} << 16;
+
+template <typename S, typename RNG, typename T, typename = void>
+struct has_fill : std::false_type {};
+template <typename S, typename RNG, typename T>
+struct has_fill<S, RNG, T,
+                std::void_t<decltype(std::declval<const S &>().Fill(std::declval<RNG &>(), std::declval<T *>(), 0))>>
+    : std::true_type {};
+
+template <typename S, typename RNG, typename T, typename = void>
+struct has_sample : std::false_type {};
+template <typename S, typename RNG, typename T>
+struct has_sample<
+    S, RNG, T, std::void_t<decltype(std::declval<const S &>().Sample(std::declval<RNG &>(), std::declval<T *>(), 0))>>
+    : std::true_type {};
+
+#if defined(RACUTILS_RANDOM_EXECUTION)
+template <typename Executor>
+constexpr bool is_execution_policy = std::is_execution_policy_v<std::decay_t<Executor>>;
+#else
+template <typename Executor>
+constexpr bool is_execution_policy = false;
+#endif
+
+// write n samples to out. Bulk Fill or Sample members are preferred, then
+// sampler(rand), then table-like samplers that map a draw, sampler(u).
+template <typename RNG, typename Sampler, typename RandomIt>
+void sample_into(RNG &rand, const Sampler &sampler, RandomIt out, size_t n) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    constexpr bool fill = has_fill<Sampler, RNG, T>::value;
+    constexpr bool sample = has_sample<Sampler, RNG, T>::value;
+    if constexpr(fill || sample) {
+        auto bulk = [&](T *p, size_t len) {
+            if constexpr(fill) {
+                sampler.Fill(rand, p, len);
+            } else {
+                sampler.Sample(rand, p, len);
+            }
+        };
+        if constexpr(std::is_pointer<RandomIt>::value) {
+            bulk(out, n);
+        } else {
+            std::array<T, SAMPLE_BLOCK_SIZE> buffer;
+            for(size_t k = 0; k < n; k += SAMPLE_BLOCK_SIZE) {
+                size_t len = std::min(SAMPLE_BLOCK_SIZE, n - k);
+                bulk(buffer.data(), len);
+                std::copy(buffer.begin(), buffer.begin() + len, out + k);
+            }
+        }
+    } else if constexpr(std::is_invocable<const Sampler &, RNG &>::value) {
+        for(size_t i = 0; i < n; ++i) {
+            out[i] = sampler(rand);
+        }
+    } else {
+        for(size_t i = 0; i < n; ++i) {
+            out[i] = sampler(rand.bits());
+        }
+    }
+}
+}  // namespace details
+
+// Fill [first, last) with samples from sampler. The range is split into
+// blocks of FILL_BLOCK_SIZE values, and block b is drawn from stream b of a
+// generator seeded by ss, so the output does not depend on how the blocks
+// are scheduled. exec(count, task) runs the blocks, e.g. ThreadExecutor.
+// std::execution policies are also accepted when RACUTILS_RANDOM_EXECUTION
+// is defined.
+// sampler may be one of the samplers above, a sampler with Fill(rand, out, n)
+// such as BoundedSampler or Poisson, an alias table, or any f(rand).
+template <typename Engine = details::RandomEngine, typename Executor, typename RandomIt, typename Sampler,
+          size_t count>
+void fill(Executor &&exec, RandomIt first, RandomIt last, const Sampler &sampler, const SeedSeq<count> &ss) {
+    using details::FILL_BLOCK_SIZE;
+    const BasicStreamPool<Engine> pool(ss);
+    const auto n = static_cast<size_t>(last - first);
+    const size_t num_blocks = (n + FILL_BLOCK_SIZE - 1) / FILL_BLOCK_SIZE;
+    auto task = [&](size_t b) {
+        auto rand = pool.Stream(b);
+        size_t lo = b * FILL_BLOCK_SIZE;
+        details::sample_into(rand, sampler, first + lo, std::min(FILL_BLOCK_SIZE, n - lo));
+    };
+    if constexpr(details::is_execution_policy<Executor>) {
+        std::vector<size_t> blocks(num_blocks);
+        std::iota(blocks.begin(), blocks.end(), 0);
+        std::for_each(exec, blocks.begin(), blocks.end(), task);
+    } else {
+        exec(num_blocks, task);
+    }
+}
+
+// sequential version, with the same output as the parallel ones
+template <typename Engine = details::RandomEngine, typename RandomIt, typename Sampler, size_t count>
+void fill(RandomIt first, RandomIt last, const Sampler &sampler, const SeedSeq<count> &ss) {
+    fill<Engine>(ThreadExecutor{1}, first, last, sampler, ss);
+}
+
+// AliasTable samples from a discrete distribution in constant time.
+// The table is padded to a power of two, 2^k, and Get(u) uses the top k bits
+// of u as the index and the next 32 bits as the probability.
+class AliasTable {
+   public:
+    AliasTable() = default;
+
+    template <typename... Args>
+    explicit AliasTable(Args &&...args) {
+        Create(std::forward<Args>(args)...);
+    }
+
+    // create the alias table
+    void CreateInplace(std::vector<double> *v);
+
+    // create the alias table using num_threads threads
+    void CreateInplace(std::vector<double> *v, unsigned int num_threads) {
+        CreateInplace(v, num_threads, ThreadExecutor{num_threads});
+    }
+
+    // create the alias table using num_tasks tasks run by exec(count, task)
+    template <typename Executor>
+    void CreateInplace(std::vector<double> *v, size_t num_tasks, Executor &&exec);
+
+    // create the alias table
+    template <typename... Args>
+    void Create(Args &&...args) {
+        std::vector<double> vv(std::forward<Args>(args)...);
+        CreateInplace(&vv);
+    }
+
+    uint32_t Get(uint64_t u) const {
+        auto yx = details::random_u32_pair(u >> shr_);
+        return (yx.first < p_[yx.second]) ? yx.second : a_[yx.second];
+    }
+
+    const std::vector<uint32_t> &a() const { return a_; }
+    const std::vector<uint32_t> &p() const { return p_; }
+
+    uint32_t operator()(uint64_t u) const { return Get(u); }
+
+    // fill [out, out+n) with samples from the table using rand
+    template <typename RNG>
+    void Sample(RNG &rand, uint32_t *out, size_t n) const;
+
+   private:
+    void Resize(std::vector<double> *v);
+
+    int shr_{0};
+    std::vector<uint32_t> a_;
+    std::vector<uint32_t> p_;
+};
+
+inline void AliasTable::Resize(std::vector<double> *v) {
+    assert(v != nullptr);
+    assert(v->size() <= (UINT64_C(1) << 32));
+    // round the size of vector up to the nearest power of two
+    auto ru = details::alias_round_up(v->size());
+    size_t sz = ru.first;
+    v->resize(sz, 0.0);
+    a_.resize(sz, 0);
+    p_.resize(sz, 0);
+    // use the number of bits to calculate the right shift operand
+    // u >> shr_ has k index bits above 32 probability bits
+    shr_ = 32 - ru.second;
+}
+
+inline void AliasTable::CreateInplace(std::vector<double> *v) {
+    Resize(v);
+    details::alias_table_sweep(v, [this](size_t i, uint32_t p, size_t a) {
+        p_[i] = p;
+        a_[i] = static_cast<uint32_t>(a);
+    });
+}
+
+// The table may differ from the sequential one, because entries are paired
+// in a different order, but it samples from the same distribution.
+template <typename Executor>
+inline void AliasTable::CreateInplace(std::vector<double> *v, size_t num_tasks, Executor &&exec) {
+    Resize(v);
+    details::alias_table_sweep(
+        v,
+        [this](size_t i, uint32_t p, size_t a) {
+            p_[i] = p;
+            a_[i] = static_cast<uint32_t>(a);
+        },
+        num_tasks, exec);
+}
+
+// Produces the same values as calling Get(rand.u64()) n times. The uniforms are
+// generated in bulk so that table entries can be prefetched several samples ahead.
+template <typename RNG>
+inline void AliasTable::Sample(RNG &rand, uint32_t *out, size_t n) const {
+    using details::SAMPLE_BLOCK_SIZE;
+    using details::SAMPLE_PREFETCH_DISTANCE;
+    std::array<uint64_t, SAMPLE_BLOCK_SIZE> u;
+    for(size_t k = 0; k < n; k += SAMPLE_BLOCK_SIZE) {
+        size_t len = std::min(SAMPLE_BLOCK_SIZE, n - k);
+        rand.fill_u64(u.data(), len);
+        RACUTILS_RANDOM_STAT_ADD(ALIAS_CALLS, len);
+        RACUTILS_RANDOM_STAT_ADD(ALIAS_DRAWS, len);
+        for(size_t i = 0; i < len; ++i) {
+            u[i] >>= shr_;
+        }
+        for(size_t i = 0; i < len && i < SAMPLE_PREFETCH_DISTANCE; ++i) {
+            details::prefetch(&p_[u[i] >> 32]);
+            details::prefetch(&a_[u[i] >> 32]);
+        }
+        for(size_t i = 0; i < len; ++i) {
+            if(i + SAMPLE_PREFETCH_DISTANCE < len) {
+                uint64_t j = u[i + SAMPLE_PREFETCH_DISTANCE] >> 32;
+                details::prefetch(&p_[j]);
+                details::prefetch(&a_[j]);
+            }
+            auto yx = details::random_u32_pair(u[i]);
+            // select without a branch
+            uint32_t mask = -static_cast<uint32_t>(yx.first < p_[yx.second]);
+            out[k + i] = (yx.second & mask) | (a_[yx.second] & ~mask);
+        }
+    }
+}
+
+// BasicPackedAliasTable stores each {p, a} pair of an alias table next to
+// each other in cache-aligned storage, so Get touches a single cache line.
+// Index is the type used to store aliases. Use uint64_t for tables with
+// more than 2^32 entries. When the table has 2^k entries with k > 32, only
+// 64-k bits are left for the probability.
+// Get(u) returns the same values as AliasTable::Get(u) for the same weights.
+template <typename Index>
+class BasicPackedAliasTable {
+   public:
+    using index_type = Index;
+
+    struct Entry {
+        uint32_t p;
+        index_type a;
+    };
+    static_assert(details::CACHE_LINE_SIZE % sizeof(Entry) == 0, "Entry must not straddle cache lines.");
+
+    using entries_type = std::vector<Entry, details::CacheAlignedAllocator<Entry>>;
+
+    BasicPackedAliasTable() = default;
+
+    template <typename... Args>
+    explicit BasicPackedAliasTable(Args &&...args) {
+        Create(std::forward<Args>(args)...);
+    }
+
+    // create the alias table
+    void CreateInplace(std::vector<double> *v);
+
+    // create the alias table using num_threads threads
+    void CreateInplace(std::vector<double> *v, unsigned int num_threads) {
+        CreateInplace(v, num_threads, ThreadExecutor{num_threads});
+    }
+
+    // create the alias table using num_tasks tasks run by exec(count, task)
+    template <typename Executor>
+    void CreateInplace(std::vector<double> *v, size_t num_tasks, Executor &&exec);
+
+    // create the alias table
+    template <typename... Args>
+    void Create(Args &&...args) {
+        std::vector<double> vv(std::forward<Args>(args)...);
+        CreateInplace(&vv);
+    }
 
-    // Constant that changes every time we compile the code
-    constexpr uint32_t compile_stamp = details::fnv(2166136261U, __DATE__ __TIME__ __FILE__);
+    index_type Get(uint64_t u) const {
+        auto i = static_cast<index_type>(u >> (64 - bits_));
+        auto p = static_cast<uint32_t>((u << bits_) >> 32);
+        const Entry &e = table_[i];
+        return (p < e.p) ? i : e.a;
+    }
 
-    // get 32-bits of system-wide entropy once
-    static uint32_t random_int = std::random_device{}();
-    // increment it every call and don't worry about race conditions
-    random_int += 0xedf19156;
+    index_type operator()(uint64_t u) const { return Get(u); }
 
-    // heap randomness
-    void *malloc_addr = malloc(sizeof(int));  // NOLINT
-    free(malloc_addr);                        // NOLINT
-    auto heap = crushto32(malloc_addr);
-    auto stack = crushto32(&malloc_addr);
+    // fill [out, out+n) with samples from the table using rand
+    template <typename RNG>
+    void Sample(RNG &rand, index_type *out, size_t n) const;
 
-    // High-resolution time information
-    auto hitime = crushto32(std::chrono::high_resolution_clock::now().time_since_epoch().count());
-    // The address of the couple of functions.
-    auto time_func = crushto32(&std::chrono::high_resolution_clock::now);
-    auto exit_func = crushto32(&_Exit);
-    auto self_func = crushto32(&auto_seed_seq);
+    const entries_type &entries() const { return table_; }
+    size_t size() const { return table_.size(); }
 
-    // Thread ID
-    auto thread_id = crushto32(std::this_thread::get_id());
+   private:
+    void Resize(std::vector<double> *v);
 
-    // PID
-#if defined(_WIN64) || defined(_WIN32)
-    auto pid = crushto32(_getpid());
-#else
-    auto pid = crushto32(getpid());
-#endif
+    int bits_{1};
+    entries_type table_;
+};
 
-#if defined(__has_builtin) && __has_builtin(__builtin_readcyclecounter)
-    auto cpu = crushto32(__builtin_readcyclecounter());
-#else
-    uint32_t cpu = 0;
-#endif
+template <typename Index>
+inline void BasicPackedAliasTable<Index>::Resize(std::vector<double> *v) {
+    assert(v != nullptr);
+    assert(v->size() - 1 <= std::numeric_limits<index_type>::max());
+    // round the size of vector up to the nearest power of two
+    auto ru = details::alias_round_up(v->size());
+    assert(ru.second < 64);
+    size_t sz = ru.first;
+    v->resize(sz, 0.0);
+    table_.assign(sz, Entry{0, 0});
+    bits_ = ru.second;
+}
 
-    return SeedSeq256(
-        {compile_stamp, random_int, heap, stack, hitime, time_func, exit_func, self_func, thread_id, pid, cpu});
+template <typename Index>
+inline void BasicPackedAliasTable<Index>::CreateInplace(std::vector<double> *v) {
+    Resize(v);
+    details::alias_table_sweep(v, [this](size_t i, uint32_t p, size_t a) {
+        table_[i] = Entry{p, static_cast<index_type>(a)};
+    });
 }
 
-class AliasTable {
+template <typename Index>
+template <typename Executor>
+inline void BasicPackedAliasTable<Index>::CreateInplace(std::vector<double> *v, size_t num_tasks, Executor &&exec) {
+    Resize(v);
+    details::alias_table_sweep(
+        v, [this](size_t i, uint32_t p, size_t a) { table_[i] = Entry{p, static_cast<index_type>(a)}; }, num_tasks,
+        exec);
+}
+
+// Produces the same values as calling Get(rand.u64()) n times.
+template <typename Index>
+template <typename RNG>
+inline void BasicPackedAliasTable<Index>::Sample(RNG &rand, index_type *out, size_t n) const {
+    using details::SAMPLE_BLOCK_SIZE;
+    using details::SAMPLE_PREFETCH_DISTANCE;
+    std::array<uint64_t, SAMPLE_BLOCK_SIZE> u;
+    const int shr = 64 - bits_;
+    for(size_t k = 0; k < n; k += SAMPLE_BLOCK_SIZE) {
+        size_t len = std::min(SAMPLE_BLOCK_SIZE, n - k);
+        rand.fill_u64(u.data(), len);
+        RACUTILS_RANDOM_STAT_ADD(ALIAS_CALLS, len);
+        RACUTILS_RANDOM_STAT_ADD(ALIAS_DRAWS, len);
+        for(size_t i = 0; i < len && i < SAMPLE_PREFETCH_DISTANCE; ++i) {
+            details::prefetch(&table_[u[i] >> shr]);
+        }
+        for(size_t i = 0; i < len; ++i) {
+            if(i + SAMPLE_PREFETCH_DISTANCE < len) {
+                details::prefetch(&table_[u[i + SAMPLE_PREFETCH_DISTANCE] >> shr]);
+            }
+            auto j = static_cast<index_type>(u[i] >> shr);
+            auto p = static_cast<uint32_t>((u[i] << bits_) >> 32);
+            const Entry &e = table_[j];
+            // select without a branch
+            index_type mask = -static_cast<index_type>(p < e.p);
+            out[k + i] = (j & mask) | (e.a & ~mask);
+        }
+    }
+}
+
+using PackedAliasTable = BasicPackedAliasTable<uint32_t>;
+using PackedAliasTable64 = BasicPackedAliasTable<uint64_t>;
+
+// CompactAliasTable is an alias table that is not padded to a power of two,
+// so its memory matches the number of weights. The index is the high word
+// of u*n, as in random_u64_range, and the high half of the low word decides
+// between the entry and its alias. Without rejection, the bias of each index
+// and each decision is at most n/2^64.
+class CompactAliasTable {
    public:
-    AliasTable() = default;
+    CompactAliasTable() = default;
 
     template <typename... Args>
-    explicit AliasTable(Args &&...args) {
-        create(std::forward<Args>(args)...);
+    explicit CompactAliasTable(Args &&...args) {
+        Create(std::forward<Args>(args)...);
     }
 
-    // create the alias table
+    // create the alias table; v is modified but not resized
     void CreateInplace(std::vector<double> *v);
 
+    // create the alias table using num_threads threads
+    void CreateInplace(std::vector<double> *v, unsigned int num_threads) {
+        CreateInplace(v, num_threads, ThreadExecutor{num_threads});
+    }
+
+    // create the alias table using num_tasks tasks run by exec(count, task)
+    template <typename Executor>
+    void CreateInplace(std::vector<double> *v, size_t num_tasks, Executor &&exec);
+
     // create the alias table
     template <typename... Args>
     void Create(Args &&...args) {
@@ -463,99 +3977,639 @@ class AliasTable {
         CreateInplace(&vv);
     }
 
-    int Get(uint64_t u) const {
-        auto yx = details::random_u32_pair(u >> shr_);
-        return (yx.first < p_[yx.second]) ? yx.second : a_[yx.second];
+    uint32_t Get(uint64_t u) const {
+        __uint128_t m = static_cast<__uint128_t>(u) * a_.size();
+        auto i = static_cast<uint32_t>(m >> 64);
+        auto y = static_cast<uint32_t>(static_cast<uint64_t>(m) >> 32);
+        return (y < p_[i]) ? i : a_[i];
     }
 
+    uint32_t operator()(uint64_t u) const { return Get(u); }
+
+    // fill [out, out+n) with samples from the table using rand
+    template <typename RNG>
+    void Sample(RNG &rand, uint32_t *out, size_t n) const;
+
     const std::vector<uint32_t> &a() const { return a_; }
     const std::vector<uint32_t> &p() const { return p_; }
-
-    int operator()(uint64_t u) const { return Get(u); }
+    size_t size() const { return a_.size(); }
 
    private:
-    template <typename T>
-    inline static std::pair<T, int> RoundUp(T x) {
-        T y = static_cast<T>(2);
-        int k = 1;
-        for(; y < x; y *= 2, ++k) {
-            /*noop*/;
-        }
-        return std::make_pair(y, k);
+    void Resize(const std::vector<double> *v) {
+        assert(v != nullptr && !v->empty());
+        assert(v->size() <= (UINT64_C(1) << 32));
+        a_.assign(v->size(), 0);
+        p_.assign(v->size(), 0);
     }
 
-    int shr_{0};
     std::vector<uint32_t> a_;
     std::vector<uint32_t> p_;
 };
 
-inline void AliasTable::CreateInplace(std::vector<double> *v) {
-    assert(v != nullptr);
-    assert(v->size() <= std::numeric_limits<uint32_t>::max());
-    // round the size of vector up to the nearest power of two
-    auto ru = RoundUp(v->size());
-    size_t sz = ru.first;
-    v->resize(sz, 0.0);
-    a_.resize(sz, 0);
-    p_.resize(sz, 0);
-    // use the number of bits to calculate the right shift operand
-    shr_ = 64 - ru.second;
+inline void CompactAliasTable::CreateInplace(std::vector<double> *v) {
+    Resize(v);
+    details::alias_table_sweep(v, [this](size_t i, uint32_t p, size_t a) {
+        p_[i] = p;
+        a_[i] = static_cast<uint32_t>(a);
+    });
+}
 
-    // find scale for input vector
-    double d = std::accumulate(v->begin(), v->end(), 0.0) / sz;
+template <typename Executor>
+inline void CompactAliasTable::CreateInplace(std::vector<double> *v, size_t num_tasks, Executor &&exec) {
+    Resize(v);
+    details::alias_table_sweep(
+        v,
+        [this](size_t i, uint32_t p, size_t a) {
+            p_[i] = p;
+            a_[i] = static_cast<uint32_t>(a);
+        },
+        num_tasks, exec);
+}
 
-    // find first large and small values
-    //     g: current large value index
-    //     m: current small value index
-    //    mm: next possible small value index
-    size_t g = 0, m = 0;
-    for(; g < sz && (*v)[g] < d; ++g) {
-        /*noop*/;
+// Produces the same values as calling Get(rand.u64()) n times.
+template <typename RNG>
+inline void CompactAliasTable::Sample(RNG &rand, uint32_t *out, size_t n) const {
+    using details::SAMPLE_BLOCK_SIZE;
+    using details::SAMPLE_PREFETCH_DISTANCE;
+    std::array<uint64_t, SAMPLE_BLOCK_SIZE> u;
+    std::array<uint32_t, SAMPLE_BLOCK_SIZE> index;
+    const uint64_t sz = a_.size();
+    for(size_t k = 0; k < n; k += SAMPLE_BLOCK_SIZE) {
+        size_t len = std::min(SAMPLE_BLOCK_SIZE, n - k);
+        rand.fill_u64(u.data(), len);
+        RACUTILS_RANDOM_STAT_ADD(ALIAS_CALLS, len);
+        RACUTILS_RANDOM_STAT_ADD(ALIAS_DRAWS, len);
+        for(size_t i = 0; i < len; ++i) {
+            __uint128_t m = static_cast<__uint128_t>(u[i]) * sz;
+            index[i] = static_cast<uint32_t>(m >> 64);
+            u[i] = static_cast<uint64_t>(m) >> 32;
+        }
+        for(size_t i = 0; i < len && i < SAMPLE_PREFETCH_DISTANCE; ++i) {
+            details::prefetch(&p_[index[i]]);
+            details::prefetch(&a_[index[i]]);
+        }
+        for(size_t i = 0; i < len; ++i) {
+            if(i + SAMPLE_PREFETCH_DISTANCE < len) {
+                uint32_t j = index[i + SAMPLE_PREFETCH_DISTANCE];
+                details::prefetch(&p_[j]);
+                details::prefetch(&a_[j]);
+            }
+            uint32_t j = index[i];
+            // select without a branch
+            uint32_t mask = -static_cast<uint32_t>(u[i] < p_[j]);
+            out[k + i] = (j & mask) | (a_[j] & ~mask);
+        }
     }
-    for(; m < sz && (*v)[m] >= d; ++m) {
-        /*noop*/;
+}
+
+// FixedAliasTable is an alias table for a small distribution whose size N is
+// known at compile time, e.g. nucleotides or codons. It needs no heap memory
+// and can be built as constexpr from constant weights. The table is padded to
+// 2^k entries, each a single word that holds the alias in its low k bits and
+// the probability in the remaining 32-k bits, so tables of up to 16 entries
+// fit in one cache line and up to 32 in two. The table is aligned so that it
+// never straddles more cache lines than it needs.
+template <size_t N>
+class FixedAliasTable {
+    static_assert(N > 0 && N <= 1024, "Use AliasTable for larger distributions.");
+
+   public:
+    static constexpr int BITS = details::alias_round_up(N).second;
+    static constexpr size_t SIZE = details::alias_round_up(N).first;
+    static constexpr uint32_t ALIAS_MASK = (UINT32_C(1) << BITS) - 1;
+
+    using table_type = std::array<uint32_t, SIZE>;
+
+    constexpr FixedAliasTable() = default;
+
+    // create the alias table from weights w[0..N)
+    constexpr explicit FixedAliasTable(const double *w) {
+        std::array<double, SIZE> v{};
+        double sum = 0.0;
+        for(size_t i = 0; i < N; ++i) {
+            assert(w[i] >= 0.0);
+            v[i] = w[i];
+            sum += w[i];
+        }
+        assert(sum > 0.0);
+        auto set_entry = [this](size_t i, uint32_t p, size_t a) {
+            table_[i] = (p & ~ALIAS_MASK) | static_cast<uint32_t>(a);
+        };
+        details::alias_table_sweep_range(v.data(), SIZE, sum / SIZE, set_entry,
+                                         [&](size_t i) { set_entry(i, std::numeric_limits<uint32_t>::max(), i); });
     }
-    size_t mm = m + 1;
 
-    // construct table
-    while(g < sz && m < sz) {
-        assert((*v)[m] < d);
-        p_[m] = static_cast<uint32_t>(4294967296.0 / d * (*v)[m]);
-        a_[m] = static_cast<uint32_t>(g);
-        (*v)[g] = ((*v)[g] + (*v)[m]) - d;
-        if((*v)[g] >= d || mm <= g) {
-            for(m = mm; m < sz && (*v)[m] >= d; ++m) {
-                /*noop*/;
+    constexpr explicit FixedAliasTable(const std::array<double, N> &w) : FixedAliasTable(w.data()) {}
+
+    constexpr uint32_t Get(uint64_t u) const {
+        auto i = static_cast<uint32_t>(u >> (64 - BITS));
+        auto y = static_cast<uint32_t>((u << BITS) >> 32);
+        uint32_t e = table_[i];
+        return (y < (e & ~ALIAS_MASK)) ? i : (e & ALIAS_MASK);
+    }
+
+    constexpr uint32_t operator()(uint64_t u) const { return Get(u); }
+
+    // fill [out, out+n) with samples from the table using rand
+    template <typename RNG>
+    void Sample(RNG &rand, uint32_t *out, size_t n) const {
+        std::array<uint64_t, details::SAMPLE_BLOCK_SIZE> u;
+        for(size_t k = 0; k < n; k += u.size()) {
+            size_t len = std::min(u.size(), n - k);
+            rand.fill_u64(u.data(), len);
+            RACUTILS_RANDOM_STAT_ADD(ALIAS_CALLS, len);
+            RACUTILS_RANDOM_STAT_ADD(ALIAS_DRAWS, len);
+            for(size_t i = 0; i < len; ++i) {
+                out[k + i] = Get(u[i]);
             }
-            mm = m + 1;
-        } else {
-            m = g;
         }
-        for(; g < sz && (*v)[g] < d; ++g) {
-            /*noop*/;
+    }
+
+    constexpr const table_type &table() const { return table_; }
+    static constexpr size_t size() { return N; }
+
+   private:
+    alignas(std::min(details::CACHE_LINE_SIZE, sizeof(table_type))) table_type table_{};
+};
+
+// DynamicDiscreteSampler samples from a discrete distribution whose weights
+// change over time. Partial sums are stored in a complete binary tree, so
+// both Set and Get are O(log n). Parent sums are recomputed from their
+// children on every update, so rounding errors do not accumulate.
+class DynamicDiscreteSampler {
+   public:
+    DynamicDiscreteSampler() = default;
+
+    template <typename... Args>
+    explicit DynamicDiscreteSampler(Args &&...args) {
+        Create(std::forward<Args>(args)...);
+    }
+
+    // create the tree
+    template <typename... Args>
+    void Create(Args &&...args) {
+        std::vector<double> vv(std::forward<Args>(args)...);
+        CreateFrom(vv);
+    }
+
+    // create the tree from weights v
+    void CreateFrom(const std::vector<double> &v);
+
+    // change the weight of entry i
+    void Set(size_t i, double w) {
+        assert(i < size_);
+        assert(w >= 0.0);
+        size_t j = leaves_ + i;
+        tree_[j] = w;
+        for(j >>= 1; j > 0; j >>= 1) {
+            tree_[j] = tree_[2 * j] + tree_[2 * j + 1];
         }
     }
-    // if we stopped early fill in the rest
-    if(g < sz) {
-        p_[g] = std::numeric_limits<uint32_t>::max();
-        a_[g] = static_cast<uint32_t>(g);
-        for(g = g + 1; g < sz; ++g) {
-            if((*v)[g] < d) continue;
-            p_[g] = std::numeric_limits<uint32_t>::max();
-            a_[g] = static_cast<uint32_t>(g);
+
+    double Weight(size_t i) const { return tree_[leaves_ + i]; }
+    double Total() const { return tree_[1]; }
+    size_t size() const { return size_; }
+
+    size_t Get(uint64_t u) const {
+        assert(Total() > 0.0);
+        double x = details::random_f53(u) * Total();
+        size_t j = 1;
+        while(j < leaves_) {
+            double left = tree_[2 * j];
+            // never descend into a subtree without weight
+            if(x < left || tree_[2 * j + 1] <= 0.0) {
+                j = 2 * j;
+            } else {
+                x -= left;
+                j = 2 * j + 1;
+            }
         }
+        return j - leaves_;
     }
-    // if we stopped early fill in the rest
-    if(m < sz) {
-        p_[m] = std::numeric_limits<uint32_t>::max();
-        a_[m] = static_cast<uint32_t>(m);
-        for(m = mm; m < sz; ++m) {
-            if((*v)[m] > d) continue;
-            p_[m] = std::numeric_limits<uint32_t>::max();
-            a_[m] = static_cast<uint32_t>(m);
+
+    size_t operator()(uint64_t u) const { return Get(u); }
+
+   private:
+    size_t size_{0};
+    size_t leaves_{0};
+    // tree_[1] is the root, and the children of j are 2*j and 2*j+1
+    std::vector<double> tree_;
+};
+
+inline void DynamicDiscreteSampler::CreateFrom(const std::vector<double> &v) {
+    assert(!v.empty());
+    size_ = v.size();
+    leaves_ = details::alias_round_up(size_).first;
+    tree_.assign(2 * leaves_, 0.0);
+    std::copy(v.begin(), v.end(), tree_.begin() + leaves_);
+    for(size_t j = leaves_ - 1; j > 0; --j) {
+        tree_[j] = tree_[2 * j] + tree_[2 * j + 1];
+    }
+}
+
+// WeightedReservoir selects k items without replacement from a stream of
+// weights in one pass, keeping only the k selected items in memory.
+// Uses A-ExpJ (Efraimidis and Spirakis 2006) with keys E/w, where E is
+// exponential: the k items with the smallest keys are kept, and once the
+// reservoir is full an exponential jump skips the items that would not
+// enter it, so only O(k log(n/k)) random values are drawn.
+class WeightedReservoir {
+   public:
+    explicit WeightedReservoir(size_t k) : k_{k} {
+        assert(k > 0);
+        heap_.reserve(k);
+    }
+
+    // offer the next item of the stream with weight w >= 0
+    template <typename RNG>
+    void Push(RNG &rand, double w);
+
+    // offer the next n items of the stream with weights w[0..n)
+    template <typename RNG>
+    void Push(RNG &rand, const double *w, size_t n);
+
+    // stream positions of the selected items in increasing order
+    std::vector<uint64_t> Items() const;
+
+    uint64_t count() const { return count_; }
+    size_t k() const { return k_; }
+
+   private:
+    // {key, stream position}, the largest key on top
+    using entry_type = std::pair<double, uint64_t>;
+
+    template <typename RNG>
+    void Insert(RNG &rand, double w);
+    template <typename RNG>
+    void Replace(RNG &rand, double w);
+
+    size_t k_;
+    uint64_t count_{0};
+    // remaining weight to skip before the next item enters the reservoir
+    double skip_{0.0};
+    std::vector<entry_type> heap_;
+};
+
+template <typename RNG>
+inline void WeightedReservoir::Insert(RNG &rand, double w) {
+    heap_.emplace_back(rand.exp() / w, count_);
+    std::push_heap(heap_.begin(), heap_.end());
+    if(heap_.size() == k_) {
+        skip_ = rand.exp() / heap_.front().first;
+    }
+}
+
+// The item entering the reservoir has a key below the current threshold t,
+// so it is drawn from an exponential truncated to [0, t*w).
+template <typename RNG>
+inline void WeightedReservoir::Replace(RNG &rand, double w) {
+    double t = heap_.front().first;
+    double key = -std::log1p(rand.f52() * std::expm1(-t * w)) / w;
+    std::pop_heap(heap_.begin(), heap_.end());
+    heap_.back() = {std::min(key, t), count_};
+    std::push_heap(heap_.begin(), heap_.end());
+    skip_ = rand.exp() / heap_.front().first;
+}
+
+template <typename RNG>
+inline void WeightedReservoir::Push(RNG &rand, double w) {
+    assert(w >= 0.0);
+    if(w > 0.0) {
+        if(heap_.size() < k_) {
+            Insert(rand, w);
+        } else if((skip_ -= w) <= 0.0) {
+            Replace(rand, w);
+        }
+    }
+    ++count_;
+}
+
+template <typename RNG>
+inline void WeightedReservoir::Push(RNG &rand, const double *w, size_t n) {
+    size_t i = 0;
+    for(; i < n && heap_.size() < k_; ++i) {
+        Push(rand, w[i]);
+    }
+    while(i < n) {
+        // skip ahead without drawing random values
+        double skip = skip_;
+        size_t j = i;
+        for(; j < n && ((skip -= w[j]) > 0.0 || w[j] == 0.0); ++j) {
+            /*noop*/;
+        }
+        count_ += j - i;
+        if(j == n) {
+            skip_ = skip;
+            break;
         }
+        Replace(rand, w[j]);
+        ++count_;
+        i = j + 1;
+    }
+}
+
+inline std::vector<uint64_t> WeightedReservoir::Items() const {
+    std::vector<uint64_t> items(heap_.size());
+    for(size_t i = 0; i < heap_.size(); ++i) {
+        items[i] = heap_[i].second;
+    }
+    std::sort(items.begin(), items.end());
+    return items;
+}
+
+// Distributions with the interface of their std:: counterparts, so that
+// generic code can switch by changing types. They work with any uniform
+// random bit generator whose range is 32 or 64 full bits, and use the same
+// fast paths as BasicRandom.
+
+namespace details {
+// 64 random bits from g, chosen at compile time from the range of g
+template <typename URBG>
+inline uint64_t urbg_u64(URBG &g) {
+    static_assert(URBG::min() == 0, "The generator must produce values starting at 0.");
+    if constexpr(URBG::max() == UINT64_MAX) {
+        return g();
+    } else {
+        static_assert(URBG::max() == UINT32_MAX, "The generator must produce 32 or 64 random bits.");
+        uint64_t hi = g();
+        return (hi << 32) | static_cast<uint32_t>(g());
     }
 }
+}  // namespace details
+
+// uniformly distributed integers between [a,b]
+template <typename IntType = int>
+class UniformIntDistribution {
+    static_assert(std::is_integral<IntType>::value && sizeof(IntType) <= sizeof(uint64_t),
+                  "IntType must be an integer type of at most 64 bits.");
+
+   public:
+    using result_type = IntType;
+
+    class param_type {
+       public:
+        using distribution_type = UniformIntDistribution;
+
+        constexpr explicit param_type(IntType a = 0, IntType b = std::numeric_limits<IntType>::max())
+            : a_{a},
+              b_{b},
+              range_{static_cast<uint64_t>(b) - static_cast<uint64_t>(a) + 1},
+              threshold_{details::random_u64_threshold(range_)} {
+            assert(a <= b);
+        }
+
+        constexpr IntType a() const { return a_; }
+        constexpr IntType b() const { return b_; }
+
+        friend constexpr bool operator==(const param_type &x, const param_type &y) {
+            return x.a_ == y.a_ && x.b_ == y.b_;
+        }
+        friend constexpr bool operator!=(const param_type &x, const param_type &y) { return !(x == y); }
+
+       private:
+        friend class UniformIntDistribution;
+
+        IntType a_;
+        IntType b_;
+        // range_ == 0 means all 2^64 values
+        uint64_t range_;
+        uint64_t threshold_;
+    };
+
+    constexpr UniformIntDistribution() : UniformIntDistribution(0) {}
+    constexpr explicit UniformIntDistribution(IntType a, IntType b = std::numeric_limits<IntType>::max())
+        : param_{a, b} {}
+    constexpr explicit UniformIntDistribution(const param_type &param) : param_{param} {}
+
+    void reset() {}
+
+    template <typename URBG>
+    result_type operator()(URBG &g) {
+        return operator()(g, param_);
+    }
+    template <typename URBG>
+    result_type operator()(URBG &g, const param_type &param) {
+        auto get = [&g]() { return details::urbg_u64(g); };
+        uint64_t u = (param.range_ == 0) ? get() : details::random_u64_range(param.range_, param.threshold_, get);
+        return static_cast<IntType>(static_cast<uint64_t>(param.a_) + u);
+    }
+
+    constexpr IntType a() const { return param_.a(); }
+    constexpr IntType b() const { return param_.b(); }
+    constexpr param_type param() const { return param_; }
+    void param(const param_type &param) { param_ = param; }
+    constexpr result_type min() const { return a(); }
+    constexpr result_type max() const { return b(); }
+
+    friend constexpr bool operator==(const UniformIntDistribution &x, const UniformIntDistribution &y) {
+        return x.param_ == y.param_;
+    }
+    friend constexpr bool operator!=(const UniformIntDistribution &x, const UniformIntDistribution &y) {
+        return !(x == y);
+    }
+
+   private:
+    param_type param_;
+};
+
+// uniformly distributed real numbers between [a,b)
+// float uses f24 and wider types use f53
+template <typename RealType = double>
+class UniformRealDistribution {
+    static_assert(std::is_floating_point<RealType>::value, "RealType must be a floating-point type.");
+
+   public:
+    using result_type = RealType;
+
+    class param_type {
+       public:
+        using distribution_type = UniformRealDistribution;
+
+        constexpr explicit param_type(RealType a = 0, RealType b = 1) : a_{a}, b_{b} { assert(a <= b); }
+
+        constexpr RealType a() const { return a_; }
+        constexpr RealType b() const { return b_; }
+
+        friend constexpr bool operator==(const param_type &x, const param_type &y) {
+            return x.a_ == y.a_ && x.b_ == y.b_;
+        }
+        friend constexpr bool operator!=(const param_type &x, const param_type &y) { return !(x == y); }
+
+       private:
+        RealType a_;
+        RealType b_;
+    };
+
+    constexpr UniformRealDistribution() : UniformRealDistribution(0) {}
+    constexpr explicit UniformRealDistribution(RealType a, RealType b = 1) : param_{a, b} {}
+    constexpr explicit UniformRealDistribution(const param_type &param) : param_{param} {}
+
+    void reset() {}
+
+    template <typename URBG>
+    result_type operator()(URBG &g) {
+        return operator()(g, param_);
+    }
+    template <typename URBG>
+    result_type operator()(URBG &g, const param_type &param) {
+        uint64_t u = details::urbg_u64(g);
+        RealType f;
+        if constexpr(std::is_same<RealType, float>::value) {
+            f = details::random_f24(details::random_u32(u));
+        } else {
+            f = details::random_f53(u);
+        }
+        return param.a() + (param.b() - param.a()) * f;
+    }
+
+    constexpr RealType a() const { return param_.a(); }
+    constexpr RealType b() const { return param_.b(); }
+    constexpr param_type param() const { return param_; }
+    void param(const param_type &param) { param_ = param; }
+    constexpr result_type min() const { return a(); }
+    constexpr result_type max() const { return b(); }
+
+    friend constexpr bool operator==(const UniformRealDistribution &x, const UniformRealDistribution &y) {
+        return x.param_ == y.param_;
+    }
+    friend constexpr bool operator!=(const UniformRealDistribution &x, const UniformRealDistribution &y) {
+        return !(x == y);
+    }
+
+   private:
+    param_type param_;
+};
+
+// true with probability p
+class BernoulliDistribution {
+   public:
+    using result_type = bool;
+
+    class param_type {
+       public:
+        using distribution_type = BernoulliDistribution;
+
+        constexpr explicit param_type(double p = 0.5) : bernoulli_{p} {}
+
+        constexpr double p() const { return bernoulli_.p(); }
+
+        friend constexpr bool operator==(const param_type &x, const param_type &y) { return x.p() == y.p(); }
+        friend constexpr bool operator!=(const param_type &x, const param_type &y) { return !(x == y); }
+
+       private:
+        friend class BernoulliDistribution;
+
+        Bernoulli bernoulli_;
+    };
+
+    constexpr BernoulliDistribution() : BernoulliDistribution(0.5) {}
+    constexpr explicit BernoulliDistribution(double p) : param_{p} {}
+    constexpr explicit BernoulliDistribution(const param_type &param) : param_{param} {}
+
+    void reset() {}
+
+    template <typename URBG>
+    result_type operator()(URBG &g) {
+        return operator()(g, param_);
+    }
+    template <typename URBG>
+    result_type operator()(URBG &g, const param_type &param) {
+        return param.bernoulli_.Get(details::urbg_u64(g));
+    }
+
+    constexpr double p() const { return param_.p(); }
+    constexpr param_type param() const { return param_; }
+    void param(const param_type &param) { param_ = param; }
+    constexpr result_type min() const { return false; }
+    constexpr result_type max() const { return true; }
+
+    friend constexpr bool operator==(const BernoulliDistribution &x, const BernoulliDistribution &y) {
+        return x.param_ == y.param_;
+    }
+    friend constexpr bool operator!=(const BernoulliDistribution &x, const BernoulliDistribution &y) {
+        return !(x == y);
+    }
+
+   private:
+    param_type param_;
+};
+
+// integers in [0,n) with probabilities proportional to n weights, sampled
+// with an AliasTable
+template <typename IntType = int>
+class DiscreteDistribution {
+    static_assert(std::is_integral<IntType>::value, "IntType must be an integer type.");
+
+   public:
+    using result_type = IntType;
+
+    class param_type {
+       public:
+        using distribution_type = DiscreteDistribution;
+
+        param_type() : param_type({1.0}) {}
+        template <typename InputIt>
+        param_type(InputIt first, InputIt last) : p_(first, last) {
+            Init();
+        }
+        param_type(std::initializer_list<double> weights) : p_(weights) { Init(); }
+
+        // normalized probabilities
+        std::vector<double> probabilities() const { return p_; }
+
+        friend bool operator==(const param_type &x, const param_type &y) { return x.p_ == y.p_; }
+        friend bool operator!=(const param_type &x, const param_type &y) { return !(x == y); }
+
+       private:
+        friend class DiscreteDistribution;
+
+        void Init() {
+            if(p_.empty()) {
+                p_.push_back(1.0);
+            }
+            double total = std::accumulate(p_.begin(), p_.end(), 0.0);
+            assert(total > 0.0);
+            for(auto &&w : p_) {
+                w /= total;
+            }
+            table_.Create(p_);
+        }
+
+        std::vector<double> p_;
+        AliasTable table_;
+    };
+
+    DiscreteDistribution() = default;
+    template <typename InputIt>
+    DiscreteDistribution(InputIt first, InputIt last) : param_(first, last) {}
+    DiscreteDistribution(std::initializer_list<double> weights) : param_(weights) {}
+    explicit DiscreteDistribution(const param_type &param) : param_{param} {}
+
+    void reset() {}
+
+    template <typename URBG>
+    result_type operator()(URBG &g) {
+        return operator()(g, param_);
+    }
+    template <typename URBG>
+    result_type operator()(URBG &g, const param_type &param) {
+        return static_cast<IntType>(param.table_(details::urbg_u64(g)));
+    }
+
+    std::vector<double> probabilities() const { return param_.probabilities(); }
+    const param_type &param() const { return param_; }
+    void param(const param_type &param) { param_ = param; }
+    result_type min() const { return 0; }
+    result_type max() const { return static_cast<IntType>(param_.p_.size() - 1); }
+
+    friend bool operator==(const DiscreteDistribution &x, const DiscreteDistribution &y) {
+        return x.param_ == y.param_;
+    }
+    friend bool operator!=(const DiscreteDistribution &x, const DiscreteDistribution &y) { return !(x == y); }
+
+   private:
+    param_type param_;
+};
 
 }  // namespace racutils::random
 
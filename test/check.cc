@@ -0,0 +1,725 @@
+// Regression checks for random.hpp
+//
+// Usage: check [--baseline file] [--tolerance x] [--record file]
+// Checks that the SIMD, interleaved and batch paths produce exactly the same
+// values as their scalar references, then times the bulk paths in ns per
+// value. With --record the timings are written to file, one "name ns" line
+// each. With --baseline a timing slower than tolerance times its baseline
+// fails the run, and so does a missing baseline or a timing that is not in
+// it. The exit status is 1 if anything failed.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN64) && !defined(_WIN32)
+#include <csignal>
+
+#include <sys/resource.h>
+#endif
+
+// also check the std::execution path of fill where the library has it
+#if __has_include(<execution>)
+#define RACUTILS_RANDOM_EXECUTION
+#endif
+
+#include "../random.hpp"
+
+using namespace racutils::random;
+
+using XoshiroRandom = BasicRandom<details::Xoshiro256StarStar>;
+
+namespace {
+
+int failures = 0;
+
+void expect(bool ok, const std::string &name) {
+    printf("%-48s %s\n", name.c_str(), ok ? "ok" : "FAILED");
+    fflush(stdout);
+    if(!ok) {
+        ++failures;
+    }
+}
+
+// sizes around block and lane boundaries
+const size_t SIZES[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, 63, 64, 65, 255, 256, 257, 511, 512, 513, 1000, 4099};
+
+// fill_u64 and Discard against repeated bits()
+template <typename RNG>
+void check_engine(const std::string &name, RNG rand) {
+    bool fill_ok = true;
+    bool discard_ok = true;
+    for(size_t n : SIZES) {
+        RNG a = rand, b = rand, c = rand;
+        std::vector<uint64_t> out(n);
+        a.fill_u64(out.data(), n);
+        for(size_t i = 0; i < n; ++i) {
+            fill_ok &= out[i] == b.bits();
+        }
+        // the state must also match afterwards
+        uint64_t next = b.bits();
+        fill_ok &= a.bits() == next;
+        c.Discard(n);
+        discard_ok &= c.bits() == next;
+        rand.bits();
+    }
+    expect(fill_ok, name + "::fill_u64");
+    expect(discard_ok, name + "::Discard");
+    RNG jumped = rand.Jump(1000);
+    rand.Discard(1000);
+    expect(jumped.bits() == rand.bits(), name + "::Jump(count)");
+}
+
+template <size_t N>
+void check_lanes() {
+    bool ok = true;
+    for(size_t n : SIZES) {
+        details::Lehmer64Fast a;
+        a.Seed(details::Lehmer64Fast::seed_type{{1, 2, 3, 4}});
+        details::Lehmer64xN<N> lanes{a};
+        std::vector<uint64_t> out(n + 5);
+        // a partial step must leave the lanes in order
+        lanes.Fill(out.data(), n);
+        lanes.Fill(out.data() + n, 5);
+        for(auto u : out) {
+            ok &= u == a();
+        }
+    }
+    expect(ok, "Lehmer64xN<" + std::to_string(N) + ">::Fill");
+}
+
+// each value of fill(rand, out, n) against ref(rand), where both start from rand
+template <typename T, typename Fill, typename Ref>
+void check_fill(const std::string &name, const Random &rand, Fill &&fill, Ref &&ref) {
+    bool ok = true;
+    for(size_t n : SIZES) {
+        Random a = rand, b = rand;
+        std::vector<T> out(n);
+        fill(a, out.data(), n);
+        std::vector<T> expected(n);
+        ref(b, expected.data(), n);
+        ok &= n == 0 || std::memcmp(out.data(), expected.data(), n * sizeof(T)) == 0;
+    }
+    expect(ok, name);
+}
+
+void check_uniforms(const Random &rand) {
+    check_fill<double>(
+        "f52_fill", rand, [](Random &r, double *out, size_t n) { r.f52_fill(out, n); },
+        [](Random &r, double *out, size_t n) { std::generate(out, out + n, [&]() { return r.f52(); }); });
+    check_fill<double>(
+        "f53_fill", rand, [](Random &r, double *out, size_t n) { r.f53_fill(out, n); },
+        [](Random &r, double *out, size_t n) { std::generate(out, out + n, [&]() { return r.f53(); }); });
+    // float fills take the low then the high half of each word
+    auto halves = [](auto convert) {
+        return [convert](Random &r, float *out, size_t n) {
+            for(size_t i = 0; i < n; i += 2) {
+                uint64_t u = r.bits();
+                out[i] = convert(static_cast<uint32_t>(u));
+                if(i + 1 < n) {
+                    out[i + 1] = convert(static_cast<uint32_t>(u >> 32));
+                }
+            }
+        };
+    };
+    check_fill<float>(
+        "f23_fill", rand, [](Random &r, float *out, size_t n) { r.f23_fill(out, n); },
+        halves([](uint32_t u) { return details::random_f23(u); }));
+    check_fill<float>(
+        "f24_fill", rand, [](Random &r, float *out, size_t n) { r.f24_fill(out, n); },
+        halves([](uint32_t u) { return details::random_f24(u); }));
+    for(uint64_t range : {UINT64_C(1), UINT64_C(10), UINT64_C(1000003), (UINT64_C(1) << 32) + 1,
+                          (UINT64_C(1) << 63) + 1, UINT64_MAX}) {
+        check_fill<uint64_t>(
+            "u64_fill/" + std::to_string(range), rand,
+            [range](Random &r, uint64_t *out, size_t n) { r.u64_fill(range, out, n); },
+            [range](Random &r, uint64_t *out, size_t n) {
+                std::generate(out, out + n, [&]() { return r.u64(range); });
+            });
+        check_fill<uint64_t>(
+            "BoundedSampler::Fill/" + std::to_string(range), rand,
+            [range](Random &r, uint64_t *out, size_t n) { BoundedSampler(range).Fill(r, out, n); },
+            [range](Random &r, uint64_t *out, size_t n) {
+                std::generate(out, out + n, [&]() { return r.u64(range); });
+            });
+    }
+}
+
+// the fast path of random_zig_block against the scalar ziggurat
+template <size_t N>
+void check_zig_block(const std::string &name, const details::zig::Tables<N> &zt, Random rand) {
+    constexpr size_t LEN = 4099;
+    std::vector<uint64_t> u(LEN);
+    rand.fill_u64(u.data(), LEN);
+    // include the extremes and the largest accepted and smallest rejected values of some layers
+    u[0] = 0;
+    u[1] = UINT64_MAX;
+    u[2] = UINT64_C(1) << 63;
+    for(size_t b = 0; b < N && 3 + 2 * b + 1 < LEN; b += 17) {
+        auto k = static_cast<uint64_t>(zt.k[b]);
+        u[3 + 2 * b] = (((k & ~static_cast<uint64_t>(zt.MASK)) | b) << 1);
+        u[3 + 2 * b + 1] = (((k + zt.MASK + 1) & ~static_cast<uint64_t>(zt.MASK)) | b) << 1;
+    }
+    std::vector<double> out(LEN);
+    std::vector<uint32_t> rejected(LEN);
+    size_t m = details::random_zig_block(u.data(), LEN, zt, out.data(), rejected.data());
+    bool ok = true;
+    size_t r = 0;
+    for(size_t i = 0; i < LEN; ++i) {
+        int64_t a = details::random_i63(u[i]);
+        auto b = static_cast<int>(a & zt.MASK);
+        if(a <= zt.k[b]) {
+            ok &= out[i] == a * zt.w[b];
+        } else {
+            ok &= r < m && rejected[r] == i;
+            ++r;
+        }
+    }
+    expect(ok && r == m, name);
+}
+
+template <typename Table>
+void check_table(const std::string &name, const Table &table, Random rand) {
+    constexpr size_t LEN = 4099;
+    Random a = rand;
+    std::vector<uint32_t> out(LEN);
+    table.Sample(a, out.data(), LEN);
+    bool ok = true;
+    for(size_t i = 0; i < LEN; ++i) {
+        ok &= out[i] == table(rand.bits());
+    }
+    expect(ok, name + "::Sample");
+}
+
+void check_alias_tables(Random rand) {
+    for(size_t size : {size_t{1}, size_t{5}, size_t{64}, size_t{1000}}) {
+        std::vector<double> weights(size);
+        for(auto &&w : weights) {
+            w = rand.exp();
+        }
+        std::string suffix = "/" + std::to_string(size);
+        AliasTable table(weights);
+        PackedAliasTable packed(weights);
+        PackedAliasTable64 packed64(weights);
+        CompactAliasTable compact(weights);
+        check_table("AliasTable" + suffix, table, rand);
+        check_table("CompactAliasTable" + suffix, compact, rand);
+        bool ok = true;
+        for(int i = 0; i < 4096; ++i) {
+            uint64_t u = rand.bits();
+            ok &= packed(u) == table(u) && packed64(u) == table(u);
+        }
+        expect(ok, "PackedAliasTable::Get" + suffix);
+        std::vector<uint32_t> out(4099);
+        std::vector<uint64_t> out64(4099);
+        Random a = rand, b = rand;
+        packed.Sample(a, out.data(), out.size());
+        packed64.Sample(b, out64.data(), out64.size());
+        for(size_t i = 0; i < out.size(); ++i) {
+            uint32_t j = table(rand.bits());
+            ok &= out[i] == j && out64[i] == j;
+        }
+        expect(ok, "PackedAliasTable::Sample" + suffix);
+    }
+    std::array<double, 61> codons;
+    for(auto &&w : codons) {
+        w = rand.exp();
+    }
+    check_table("FixedAliasTable<61>", FixedAliasTable<61>(codons), rand);
+}
+
+void check_seeding() {
+    SeedSeq256 master({1u, 2u, 3u});
+    std::vector<uint64_t> ids(1000);
+    for(size_t i = 0; i < ids.size(); ++i) {
+        ids[i] = i * i + (i << 40);
+    }
+    std::vector<Random::seed_type> batch(ids.size());
+    master.GenerateBatch(ids.data(), ids.size(), batch.data());
+    bool ok = true;
+    for(size_t i = 0; i < ids.size(); ++i) {
+        Random::seed_type seed;
+        master.Spawn(ids[i]).Generate(seed.begin(), seed.end());
+        ok &= seed == batch[i];
+    }
+    expect(ok, "SeedSeq::GenerateBatch");
+}
+
+void check_streams() {
+    SeedSeq256 ss({4u, 5u});
+    const size_t n = 5 * details::FILL_BLOCK_SIZE / 2;
+    std::vector<double> expected(n);
+    StreamPool pool(ss);
+    for(size_t lo = 0, b = 0; lo < n; lo += details::FILL_BLOCK_SIZE, ++b) {
+        pool.Stream(b).f52_fill(expected.data() + lo, std::min(details::FILL_BLOCK_SIZE, n - lo));
+    }
+    for(unsigned int threads : {1u, 2u, 3u}) {
+        std::vector<double> out(n);
+        fill(ThreadExecutor{threads}, out.begin(), out.end(), F52Sampler{}, ss);
+        expect(out == expected, "fill(F52Sampler)/threads:" + std::to_string(threads));
+    }
+#if defined(RACUTILS_RANDOM_EXECUTION)
+    std::vector<double> out(n);
+    fill(std::execution::seq, out.begin(), out.end(), F52Sampler{}, ss);
+    expect(out == expected, "fill(F52Sampler)/execution::seq");
+#endif
+}
+
+// Local must stay on its stream while nested tasks and other pools use the
+// same thread
+void check_local_streams() {
+    StreamPool a(SeedSeq256({4u, 5u})), b(SeedSeq256({6u}));
+    Random expected = a.Stream(3);
+    bool ok = true;
+    {
+        auto outer = a.Local(3);
+        for(int round = 0; round < 4; ++round) {
+            ok &= outer->bits() == expected.bits();
+            auto inner = a.Local(7), other = b.Local(3);
+            Random inner_expected = a.Stream(7), other_expected = b.Stream(3);
+            for(int i = 0; i < round; ++i) {
+                ok &= inner->bits() == inner_expected.bits() && other->bits() == other_expected.bits();
+            }
+        }
+        ok &= outer->bits() == expected.bits();
+    }
+    std::vector<uint64_t> out(64), ref(64);
+    ThreadExecutor{3}(out.size(), [&](size_t t) {
+        auto rng = a.Local(t);
+        out[t] = rng->bits();
+    });
+    for(size_t t = 0; t < ref.size(); ++t) {
+        ref[t] = a.Stream(t).bits();
+    }
+    expect(ok && out == ref, "StreamPool::Local");
+}
+
+// Streams must not be related at equal positions. Interleave one value from
+// each of 1024 streams and run a chi-square test on pairs of consecutive
+// values, at several bit positions.
+template <typename RNG>
+void check_interleaved_streams(const std::string &name, const RNG &rand) {
+    std::vector<RNG> streams;
+    for(uint64_t k = 0; k < 1024; ++k) {
+        streams.push_back(rand.Stream(k));
+    }
+    constexpr size_t N = size_t{1} << 22;
+    std::vector<uint64_t> u(N);
+    for(size_t i = 0; i < N; ++i) {
+        u[i] = streams[i % streams.size()].bits();
+    }
+    double worst = 0.0;
+    for(int shift : {0, 2, 16, 32, 58}) {
+        std::vector<double> cells(4096, 0.0);
+        for(size_t i = 1; i < N; ++i) {
+            cells[(((u[i - 1] >> shift) & 63) << 6) | ((u[i] >> shift) & 63)] += 1.0;
+        }
+        double expected = static_cast<double>(N - 1) / cells.size();
+        double chi = 0.0;
+        for(double c : cells) {
+            chi += (c - expected) * (c - expected) / expected;
+        }
+        // normal approximation of the chi-square distribution
+        double df = cells.size() - 1.0;
+        worst = std::max(worst, std::abs(chi - df) / std::sqrt(2.0 * df));
+    }
+    expect(worst < 6.0, name + "::Stream/interleaved");
+}
+
+// sample_k must return k distinct sorted values, each equally likely, on both
+// the sparse and the dense path
+void check_sample_k(Random rand) {
+    bool ok = true;
+    for(auto nk : {std::pair<uint64_t, uint64_t>{1000, 50}, {20, 5}, {100, 100}, {UINT64_C(1) << 40, 1000}}) {
+        uint64_t n = nk.first, k = nk.second;
+        bool counted = n <= 1000;
+        std::vector<double> cells(counted ? n : 0, 0.0);
+        const int trials = counted ? 20000 : 10;
+        std::vector<uint64_t> out(k);
+        for(int t = 0; t < trials; ++t) {
+            ok &= rand.sample_k(n, k, out.begin()) == out.end();
+            ok &= std::adjacent_find(out.begin(), out.end(), std::greater_equal<uint64_t>()) == out.end();
+            ok &= out.empty() || out.back() < n;
+            for(uint64_t x : out) {
+                if(counted) {
+                    cells[x] += 1.0;
+                }
+            }
+        }
+        if(counted && k < n) {
+            double expected = static_cast<double>(trials) * k / n;
+            double chi = 0.0;
+            for(double c : cells) {
+                chi += (c - expected) * (c - expected) / expected;
+            }
+            double df = n - 1.0;
+            ok &= std::abs(chi - df) / std::sqrt(2.0 * df) < 6.0;
+        }
+    }
+    ok &= rand.sample_k(0, 0, static_cast<uint64_t *>(nullptr)) == nullptr;
+    expect(ok, "sample_k");
+}
+
+// BufferedRandom and ReplayRandom against the generator they wrap
+void check_wrappers(const Random &rand) {
+    Random a = rand, b = rand;
+    BufferedRandom buffered(a);
+    bool ok = true;
+    for(int i = 0; i < 1000; ++i) {
+        ok &= buffered.bits() == b.bits();
+    }
+    expect(ok, "BufferedRandom::bits");
+
+    Random live = rand;
+    std::vector<uint64_t> recording(1 << 16);
+    Random(rand).fill_u64(recording.data(), recording.size());
+    ReplayRandom replay(recording.data(), recording.size());
+    ok = true;
+    for(int i = 0; i < 1000; ++i) {
+        ok &= replay.exp() == live.exp() && replay.normal() == live.normal() &&
+              replay.u64(1000003) == live.u64(1000003) && replay.f52() == live.f52();
+    }
+    std::vector<double> x(1000), y(1000);
+    replay.normal_fill(x.data(), x.size());
+    live.normal_fill(y.data(), y.size());
+    expect(ok && x == y, "ReplayRandom");
+}
+
+// returns true if f() throws E
+template <typename E, typename F>
+bool throws(F &&f) {
+    try {
+        f();
+    } catch(const E &) {
+        return true;
+    }
+    return false;
+}
+
+// a replay must fail instead of reusing values or reading past its end
+void check_replay_errors(const Random &rand) {
+    uint64_t out[4] = {0, 0, 0, 0};
+    bool ok = throws<std::out_of_range>([&]() { ReplayRandom(nullptr, 0).bits(); });
+    ok &= throws<std::out_of_range>([&]() { ReplayRandom(nullptr, 0).fill_u64(out, 1); });
+    ReplayRandom(nullptr, 0).fill_u64(out, 0);
+
+    std::vector<uint64_t> recording(3);
+    Random(rand).fill_u64(recording.data(), recording.size());
+    ReplayRandom replay(recording.data(), recording.size());
+    ok &= throws<std::out_of_range>([&]() { replay.fill_u64(out, 4); }) && replay.remaining() == 3;
+    ok &= throws<std::out_of_range>([&]() { replay.Discard(4); }) && replay.remaining() == 3;
+    replay.Discard(1);
+    ok &= replay.bits() == recording[1] && replay.bits() == recording[2] && replay.remaining() == 0;
+    ok &= throws<std::out_of_range>([&]() { replay.bits(); });
+    replay.Seed({});
+    ok &= replay.bits() == recording[0];
+    expect(ok, "ReplayRandom errors");
+}
+
+#if !defined(_WIN64) && !defined(_WIN32)
+// record to a stream file and replay it
+void check_stream_files(const Random &rand) {
+    const char *path = "check_stream.tmp";
+    StreamFileInfo written = stream_file_info(rand, 2, 5);
+    Random live;
+    StreamFileWriter writer;
+    bool ok = stream_file_start(written, &live) && writer.Open(path, written) && writer.Record(live, 1000) &&
+              writer.Close();
+    StreamFileReader reader;
+    ok &= reader.Open(path) && reader.size() == 1000 && reader.info().engine_id == Random::ENGINE_ID &&
+          reader.info().stream == 2 && reader.info().offset == 5 && reader.info().seed == encode_seed(rand.GetSeed());
+    // the header alone must lead back to the recorded values
+    Random start;
+    XoshiroRandom other;
+    StreamFileInfo corrupted = reader.info();
+    corrupted.seed[3] = '0';
+    ok &= stream_file_start(reader.info(), &start) && !stream_file_start(reader.info(), &other) &&
+          !stream_file_start(corrupted, &live);
+    Random expected = rand.Stream(2).Jump(5);
+    ReplayRandom replay = reader.Replay();
+    for(int i = 0; i < 100; ++i) {
+        double e = expected.exp();
+        ok &= replay.exp() == e && start.exp() == e;
+    }
+    reader.Close();
+    ok &= throws<std::invalid_argument>([&]() { reader.Replay(); });
+
+    // a recording of floats cannot be replayed as engine output
+    StreamFileInfo info;
+    info.value_size = sizeof(float);
+    std::vector<float> x(10, 0.5f);
+    ok &= writer.Open(path, info) && writer.Write(x.data(), x.size()) && writer.Close();
+    ok &= reader.Open(path) && reader.data<uint64_t>() == nullptr && reader.data<float>()[9] == 0.5f;
+    ok &= throws<std::invalid_argument>([&]() { reader.Replay(); });
+    reader.Close();
+    std::remove(path);
+    expect(ok, "StreamFileWriter and StreamFileReader");
+}
+
+// a grow that fails must keep the values recorded so far
+void check_stream_file_grow_error(const Random &rand) {
+    const char *path = "check_stream.tmp";
+    struct rlimit old_limit;
+    if(getrlimit(RLIMIT_FSIZE, &old_limit) != 0) {
+        return;
+    }
+    auto old_handler = std::signal(SIGXFSZ, SIG_IGN);
+    struct rlimit limit = old_limit;
+    limit.rlim_cur = STREAM_FILE_DATA_OFFSET + StreamFileWriter::GROW_SIZE;
+    Random live = rand;
+    StreamFileWriter writer;
+    bool ok = setrlimit(RLIMIT_FSIZE, &limit) == 0 && writer.Open(path, stream_file_info(rand)) &&
+              writer.Record(live, 1000) && !writer.Record(live, StreamFileWriter::GROW_SIZE / sizeof(uint64_t));
+    setrlimit(RLIMIT_FSIZE, &old_limit);
+    std::signal(SIGXFSZ, old_handler);
+    StreamFileReader reader;
+    ok &= reader.Open(path) && reader.size() == 1000;
+    if(ok) {
+        std::vector<uint64_t> expected(1000);
+        Random(rand).fill_u64(expected.data(), expected.size());
+        ok = std::equal(expected.begin(), expected.end(), reader.data<uint64_t>());
+    }
+    reader.Close();
+    std::remove(path);
+    expect(ok, "StreamFileWriter grow error");
+}
+#endif
+
+// write_checkpoint, read_checkpoint and checkpoint_view round trips, the
+// little-endian layout, and rejection of bad input
+void check_checkpoints(const Random &rand) {
+    std::vector<Random> engines;
+    for(uint64_t k = 0; k < 3; ++k) {
+        engines.push_back(rand.Stream(k));
+    }
+    const size_t size = checkpoint_size<Random>(engines.size());
+    std::vector<uint64_t> storage(size / 8 + 1);
+    auto *buffer = reinterpret_cast<unsigned char *>(storage.data());
+    bool ok = write_checkpoint(engines.data(), engines.size(), buffer, size);
+
+    // header and state words are little-endian 64-bit words
+    auto word = [&](size_t i) {
+        uint64_t u = 0;
+        for(int b = 7; b >= 0; --b) {
+            u = (u << 8) | buffer[8 * i + b];
+        }
+        return u;
+    };
+    ok &= std::memcmp(buffer, "RACRNGCK", 8) == 0 && word(1) == 1 && word(2) == Random::ENGINE_ID &&
+          word(3) == Random::STATE_WORDS && word(4) == engines.size();
+    std::array<uint64_t, Random::STATE_WORDS> w;
+    engines[1].GetStateWords(w.data());
+    for(size_t i = 0; i < w.size(); ++i) {
+        ok &= word(8 + Random::STATE_WORDS + i) == w[i];
+    }
+    expect(ok, "write_checkpoint");
+
+    std::vector<Random> restored(engines.size());
+    ok = checkpoint_count<Random>(buffer, size) == engines.size() &&
+         read_checkpoint(buffer, size, restored.data(), restored.size());
+    for(size_t i = 0; i < engines.size(); ++i) {
+        ok &= Random(restored[i]).bits() == Random(engines[i]).bits();
+    }
+    size_t n = 0;
+    Random *view = checkpoint_view<Random>(buffer, size, &n);
+    ok &= view != nullptr && n == engines.size() && view[2].GetSeed() == engines[2].GetSeed();
+    expect(ok, "read_checkpoint");
+
+    ok = !write_checkpoint(engines.data(), 0, buffer, size);
+    ok &= !write_checkpoint(engines.data(), engines.size(), buffer, size - 1);
+    ok &= checkpoint_count<Random>(buffer, size - 1) == 0;
+    ok &= !read_checkpoint(buffer, size - 1, restored.data(), restored.size());
+    ok &= !read_checkpoint(buffer, size, restored.data(), restored.size() - 1);
+    ok &= checkpoint_count<XoshiroRandom>(buffer, size) == 0;
+    std::vector<XoshiroRandom> xoshiro(engines.size());
+    ok &= !read_checkpoint(buffer, size, xoshiro.data(), xoshiro.size());
+    buffer[0] ^= 1;
+    ok &= checkpoint_count<Random>(buffer, size) == 0;
+    expect(ok, "read_checkpoint rejects bad input");
+}
+
+// known answers from the Random123 distribution
+void check_philox() {
+    using details::Philox2x64;
+    auto a = Philox2x64::Block({0, 0}, 0);
+    auto b = Philox2x64::Block({~0ULL, ~0ULL}, ~0ULL);
+    expect(a[0] == 0xca00a0459843d731ULL && a[1] == 0x66c24222c9a845b5ULL && b[0] == 0x65b021d60cd8310fULL &&
+               b[1] == 0x4d02f3222f86df20ULL,
+           "Philox2x64 known answers");
+}
+
+// keep the compiler from optimizing away a value
+template <typename T>
+inline void do_not_optimize(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// fastest of several runs of f(out, n) over a buffer, in ns per value
+template <typename T, typename F>
+double time_fill(size_t n, F &&f) {
+    std::vector<T> buffer(4096);
+    double best = 1e300;
+    for(int r = 0; r < 5; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < n; i += buffer.size()) {
+            f(buffer.data(), std::min(buffer.size(), n - i));
+            do_not_optimize(buffer[0]);
+        }
+        auto stop = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(stop - start).count() / n);
+    }
+    return best;
+}
+
+std::vector<std::pair<std::string, double>> time_paths() {
+    constexpr size_t N = 1 << 22;
+    Random rand;
+    rand.Seed(123u);
+    std::vector<double> weights(1024);
+    for(auto &&w : weights) {
+        w = rand.exp();
+    }
+    AliasTable table(weights);
+    std::array<double, 61> codons;
+    std::copy(weights.begin(), weights.begin() + codons.size(), codons.begin());
+    FixedAliasTable<61> fixed(codons);
+
+    std::vector<std::pair<std::string, double>> timings;
+    auto add = [&](const char *name, double ns) {
+        printf("%-48s %10.3f ns/value\n", name, ns);
+        fflush(stdout);
+        timings.emplace_back(name, ns);
+    };
+    add("bits", time_fill<uint64_t>(N, [&](uint64_t *out, size_t n) {
+            for(size_t i = 0; i < n; ++i) {
+                out[i] = rand.bits();
+            }
+        }));
+    add("fill_u64", time_fill<uint64_t>(N, [&](uint64_t *out, size_t n) { rand.fill_u64(out, n); }));
+    add("u64_fill/1000003", time_fill<uint64_t>(N, [&](uint64_t *out, size_t n) { rand.u64_fill(1000003, out, n); }));
+    add("f52_fill", time_fill<double>(N, [&](double *out, size_t n) { rand.f52_fill(out, n); }));
+    add("f24_fill", time_fill<float>(N, [&](float *out, size_t n) { rand.f24_fill(out, n); }));
+    add("exp_fill", time_fill<double>(N, [&](double *out, size_t n) { rand.exp_fill(out, n); }));
+    add("normal_fill", time_fill<double>(N, [&](double *out, size_t n) { rand.normal_fill(out, n); }));
+    add("AliasTable::Sample/1024",
+        time_fill<uint32_t>(N, [&](uint32_t *out, size_t n) { table.Sample(rand, out, n); }));
+    add("FixedAliasTable<61>::Sample",
+        time_fill<uint32_t>(N, [&](uint32_t *out, size_t n) { fixed.Sample(rand, out, n); }));
+    return timings;
+}
+
+std::map<std::string, double> read_timings(const char *path) {
+    std::map<std::string, double> timings;
+    FILE *file = fopen(path, "r");
+    if(file == nullptr) {
+        return timings;
+    }
+    char name[256];
+    double ns;
+    while(fscanf(file, "%255s %lf", name, &ns) == 2) {
+        timings[name] = ns;
+    }
+    fclose(file);
+    return timings;
+}
+
+bool write_timings(const char *path, const std::vector<std::pair<std::string, double>> &timings) {
+    FILE *file = fopen(path, "w");
+    if(file == nullptr) {
+        return false;
+    }
+    for(auto &&t : timings) {
+        fprintf(file, "%s %.3f\n", t.first.c_str(), t.second);
+    }
+    return fclose(file) == 0;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    const char *baseline = nullptr;
+    const char *record = nullptr;
+    double tolerance = 1.5;
+    for(int i = 1; i + 1 < argc; i += 2) {
+        if(strcmp(argv[i], "--baseline") == 0) {
+            baseline = argv[i + 1];
+        } else if(strcmp(argv[i], "--record") == 0) {
+            record = argv[i + 1];
+        } else if(strcmp(argv[i], "--tolerance") == 0) {
+            tolerance = atof(argv[i + 1]);
+        } else {
+            fprintf(stderr, "Usage: %s [--baseline file] [--tolerance x] [--record file]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    Random rand;
+    rand.Seed(SeedSeq256({2024u, 10u}));
+    XoshiroRandom xoshiro(details::Xoshiro256StarStar::seed_type{{1, 2, 3, 4, 5, 6, 7, 8}});
+    PhiloxRandom philox(details::Philox2x64::seed_type{{1, 2}});
+    check_engine("Random", rand);
+    check_engine("XoshiroRandom", xoshiro);
+    check_engine("PhiloxRandom", philox);
+    check_lanes<1>();
+    check_lanes<4>();
+    check_lanes<8>();
+    check_uniforms(rand);
+    check_zig_block("random_zig_block/exp", details::exp_zig_tables<256>, rand);
+    check_zig_block("random_zig_block/normal", details::normal_zig_tables<256>, rand);
+    check_alias_tables(rand);
+    check_seeding();
+    check_interleaved_streams("Random", rand);
+    check_interleaved_streams("XoshiroRandom", xoshiro);
+    check_interleaved_streams("PhiloxRandom", philox);
+    check_streams();
+    check_local_streams();
+    check_sample_k(rand);
+    check_wrappers(rand);
+    check_replay_errors(rand);
+#if !defined(_WIN64) && !defined(_WIN32)
+    check_stream_files(rand);
+    check_stream_file_grow_error(rand);
+#endif
+    check_checkpoints(rand);
+    check_philox();
+
+    printf("\n");
+    auto timings = time_paths();
+    if(record != nullptr && !write_timings(record, timings)) {
+        fprintf(stderr, "Unable to write %s\n", record);
+        ++failures;
+    }
+    if(baseline == nullptr) {
+        printf("\nNo --baseline given; the timings were not compared.\n");
+    } else {
+        auto expected = read_timings(baseline);
+        if(expected.empty()) {
+            printf("\nNo baseline timings in %s; run make check-baseline to create them.\n", baseline);
+            ++failures;
+        }
+        for(auto &&t : timings) {
+            auto it = expected.find(t.first);
+            if(it == expected.end()) {
+                if(!expected.empty()) {
+                    printf("%s has no baseline; run make check-baseline to add it\n", t.first.c_str());
+                    ++failures;
+                }
+            } else if(t.second > tolerance * it->second) {
+                printf("%s regressed: %.3f ns/value, baseline %.3f ns/value\n", t.first.c_str(), t.second,
+                       it->second);
+                ++failures;
+            }
+        }
+    }
+    printf("\n%d failures\n", failures);
+    return failures != 0 ? 1 : 0;
+}
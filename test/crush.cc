@@ -0,0 +1,322 @@
+// Statistical tests of the engines and bulk APIs of random.hpp
+//
+// Usage: crush small|big [source ...]
+//        crush practrand source
+//        crush list
+// small and big run the TestU01 SmallCrush or BigCrush battery on the named
+// sources, or on all of them. A source fails if any p-value is outside
+// [1e-10, 1-1e-10], which TestU01 reports as a clear failure. The exit
+// status is the number of failed sources.
+// practrand writes a source to stdout as 32-bit words without end, e.g.
+//     crush practrand Random::fill_u64 | RNG_test stdin32
+// Every source is a stream of 32-bit words. Generators are split into their
+// high and low halves, and real values in [0,1) are scaled to 2^32. Floats
+// are packed two per word, so that every bit of a word is tested.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "../random.hpp"
+
+extern "C" {
+#include <bbattery.h>
+#include <unif01.h>
+}
+
+using namespace racutils::random;
+
+using LehmerRandom = BasicRandom<details::Lehmer64Fast>;
+using XoshiroRandom = BasicRandom<details::Xoshiro256StarStar>;
+
+namespace {
+
+constexpr size_t BLOCK_SIZE = 4096;
+
+// fill(out) writes BLOCK_SIZE words to out
+struct Source {
+    std::string name;
+    std::function<void(uint32_t *out)> fill;
+};
+
+const SeedSeq256 SEED({20240601u, 1u});
+
+template <typename RNG>
+RNG seeded() {
+    RNG rand;
+    rand.Seed(SEED);
+    return rand;
+}
+
+// words from a generator of 64-bit values, e.g. fill_u64
+template <typename F>
+Source words64(std::string name, F &&fill) {
+    return {std::move(name), [fill, u = std::vector<uint64_t>(BLOCK_SIZE / 2)](uint32_t *out) mutable {
+                fill(u.data(), u.size());
+                for(size_t i = 0; i < u.size(); ++i) {
+                    out[2 * i] = static_cast<uint32_t>(u[i] >> 32);
+                    out[2 * i + 1] = static_cast<uint32_t>(u[i]);
+                }
+            }};
+}
+
+// words from a generator of values in [0,1)
+template <typename F>
+Source unit(std::string name, F &&fill) {
+    return {std::move(name), [fill, x = std::vector<double>(BLOCK_SIZE)](uint32_t *out) mutable {
+                fill(x.data(), x.size());
+                for(size_t i = 0; i < x.size(); ++i) {
+                    out[i] = static_cast<uint32_t>(std::min(x[i] * 0x1p32, 0x1p32 - 1));
+                }
+            }};
+}
+
+// words from two floats in [0,1), each giving 16 bits
+template <typename F>
+Source unit_pairs(std::string name, F &&fill) {
+    return {std::move(name), [fill, x = std::vector<float>(2 * BLOCK_SIZE)](uint32_t *out) mutable {
+                fill(x.data(), x.size());
+                for(size_t i = 0; i < BLOCK_SIZE; ++i) {
+                    auto hi = static_cast<uint32_t>(x[2 * i] * 0x1p16f);
+                    auto lo = static_cast<uint32_t>(x[2 * i + 1] * 0x1p16f);
+                    out[i] = (hi << 16) | lo;
+                }
+            }};
+}
+
+// transform exponential and normal values to uniforms with their CDFs
+double exp_cdf(double x) { return -std::expm1(-x); }
+double normal_cdf(double x) { return 0.5 * std::erfc(-x / std::sqrt(2.0)); }
+
+// repeated calls to rand.bits()
+template <typename RNG>
+auto bits(RNG rand) {
+    return [rand](uint64_t *out, size_t n) mutable {
+        for(size_t i = 0; i < n; ++i) {
+            out[i] = rand.bits();
+        }
+    };
+}
+
+template <typename RNG>
+auto fill_u64(RNG rand) {
+    return [rand](uint64_t *out, size_t n) mutable { rand.fill_u64(out, n); };
+}
+
+// one value from each of 1024 streams in turn
+template <typename RNG>
+auto interleaved() {
+    std::vector<RNG> streams;
+    RNG rand = seeded<RNG>();
+    for(uint64_t k = 0; k < 1024; ++k) {
+        streams.push_back(rand.Stream(k));
+    }
+    return [streams, k = size_t{0}](uint64_t *out, size_t n) mutable {
+        for(size_t i = 0; i < n; ++i, k = (k + 1) % streams.size()) {
+            out[i] = streams[k].bits();
+        }
+    };
+}
+
+template <typename F>
+void generate(double *out, size_t n, F &&f) {
+    for(size_t i = 0; i < n; ++i) {
+        out[i] = f();
+    }
+}
+
+std::vector<Source> make_sources() {
+    std::vector<Source> sources;
+
+    // engines and bulk fills
+    sources.push_back(words64("Random::bits", bits(seeded<Random>())));
+    sources.push_back(words64("Random::bits/bswap", [rand = seeded<Random>()](uint64_t *out, size_t n) mutable {
+        for(size_t i = 0; i < n; ++i) {
+            out[i] = __builtin_bswap64(rand.bits());
+        }
+    }));
+    sources.push_back(words64("Random::fill_u64", fill_u64(seeded<Random>())));
+    sources.push_back(
+        words64("Lehmer64x8::Fill", [lanes = details::Lehmer64x8{seeded<LehmerRandom>()}](
+                                        uint64_t *out, size_t n) mutable { lanes.Fill(out, n); }));
+    sources.push_back(words64("BufferedRandom::bits", bits(BufferedRandom{seeded<Random>()})));
+    sources.push_back(words64("XoshiroRandom::bits", bits(seeded<XoshiroRandom>())));
+    sources.push_back(words64("XoshiroRandom::fill_u64", fill_u64(seeded<XoshiroRandom>())));
+    sources.push_back(words64("PhiloxRandom::bits", bits(seeded<PhiloxRandom>())));
+    // draws taken in counter order across many streams
+    sources.push_back(words64("PhiloxRandom::streams", [rand = seeded<PhiloxRandom>(), counter = uint64_t{0}](
+                                                           uint64_t *out, size_t n) mutable {
+        for(size_t i = 0; i < n; ++i, ++counter) {
+            out[i] = rand.u64(counter % 1024, counter / 1024);
+        }
+    }));
+    sources.push_back(words64("Random::Stream/interleaved", interleaved<Random>()));
+    sources.push_back(words64("XoshiroRandom::Stream/interleaved", interleaved<XoshiroRandom>()));
+    // the seeds of sibling streams, one after another
+    sources.push_back({"SeedSeq::GenerateBatch", [ids = std::vector<uint64_t>(BLOCK_SIZE / 8),
+                                                  seeds = std::vector<std::array<uint32_t, 8>>(BLOCK_SIZE / 8),
+                                                  id = uint64_t{0}](uint32_t *out) mutable {
+                           std::iota(ids.begin(), ids.end(), id);
+                           id += ids.size();
+                           SEED.GenerateBatch(ids.data(), ids.size(), seeds.data());
+                           std::memcpy(out, seeds.data(), BLOCK_SIZE * sizeof(uint32_t));
+                       }});
+
+    // uniform integers and reals
+    constexpr uint64_t RANGE = UINT64_C(132799643625263);
+    sources.push_back(unit("Random::u64", [rand = seeded<Random>()](double *out, size_t n) mutable {
+        generate(out, n, [&]() { return static_cast<double>(rand.u64(RANGE)) / RANGE; });
+    }));
+    sources.push_back(unit("Random::u64_fill", [rand = seeded<Random>(), u = std::vector<uint64_t>(BLOCK_SIZE)](
+                                                   double *out, size_t n) mutable {
+        rand.u64_fill(RANGE, u.data(), n);
+        for(size_t i = 0; i < n; ++i) {
+            out[i] = static_cast<double>(u[i]) / RANGE;
+        }
+    }));
+    sources.push_back(unit("Random::f52", [rand = seeded<Random>()](double *out, size_t n) mutable {
+        generate(out, n, [&]() { return rand.f52(); });
+    }));
+    sources.push_back(unit("Random::f53", [rand = seeded<Random>()](double *out, size_t n) mutable {
+        generate(out, n, [&]() { return rand.f53(); });
+    }));
+    sources.push_back(unit("Random::f52_fill", [rand = seeded<Random>()](double *out, size_t n) mutable {
+        rand.f52_fill(out, n);
+    }));
+    sources.push_back(unit("Random::f53_fill", [rand = seeded<Random>()](double *out, size_t n) mutable {
+        rand.f53_fill(out, n);
+    }));
+    sources.push_back(unit_pairs("Random::f24_fill", [rand = seeded<Random>()](float *out, size_t n) mutable {
+        rand.f24_fill(out, n);
+    }));
+    sources.push_back(unit_pairs("Random::f23_fill", [rand = seeded<Random>()](float *out, size_t n) mutable {
+        rand.f23_fill(out, n);
+    }));
+    // consecutive blocks of fill are drawn from consecutive streams
+    sources.push_back(unit("fill/F52Sampler", [x = std::vector<double>(64 * details::FILL_BLOCK_SIZE),
+                                                pos = 64 * details::FILL_BLOCK_SIZE,
+                                                refills = uint64_t{0}](double *out, size_t n) mutable {
+        for(size_t i = 0; i < n; ++i, ++pos) {
+            if(pos == x.size()) {
+                fill(ThreadExecutor{}, x.begin(), x.end(), F52Sampler{}, SEED.Spawn(refills++));
+                pos = 0;
+            }
+            out[i] = x[pos];
+        }
+    }));
+
+    // ziggurats
+    sources.push_back(unit("Random::exp", [rand = seeded<Random>()](double *out, size_t n) mutable {
+        generate(out, n, [&]() { return exp_cdf(rand.exp()); });
+    }));
+    sources.push_back(unit("Random::exp_fill", [rand = seeded<Random>()](double *out, size_t n) mutable {
+        rand.exp_fill(out, n);
+        for(size_t i = 0; i < n; ++i) {
+            out[i] = exp_cdf(out[i]);
+        }
+    }));
+    sources.push_back(unit("Random::normal", [rand = seeded<Random>()](double *out, size_t n) mutable {
+        generate(out, n, [&]() { return normal_cdf(rand.normal()); });
+    }));
+    sources.push_back(unit("Random::normal_fill", [rand = seeded<Random>()](double *out, size_t n) mutable {
+        rand.normal_fill(out, n);
+        for(size_t i = 0; i < n; ++i) {
+            out[i] = normal_cdf(out[i]);
+        }
+    }));
+    return sources;
+}
+
+// the source read by next_word
+Source *current = nullptr;
+std::vector<uint32_t> buffer(BLOCK_SIZE);
+size_t pos = BLOCK_SIZE;
+
+unsigned int next_word() {
+    if(pos == BLOCK_SIZE) {
+        current->fill(buffer.data());
+        pos = 0;
+    }
+    return buffer[pos++];
+}
+
+// returns true if source passes the battery
+bool crush(Source &source, bool big) {
+    current = &source;
+    pos = BLOCK_SIZE;
+    std::vector<char> name(source.name.begin(), source.name.end());
+    name.push_back('\0');
+    unif01_Gen *gen = unif01_CreateExternGenBits(name.data(), next_word);
+    if(big) {
+        bbattery_BigCrush(gen);
+    } else {
+        bbattery_SmallCrush(gen);
+    }
+    unif01_DeleteExternGenBits(gen);
+    bool ok = true;
+    for(int i = 0; i < bbattery_NTests; ++i) {
+        double p = bbattery_pVal[i];
+        if(p >= 0.0 && (p < 1e-10 || p > 1.0 - 1e-10)) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    std::vector<Source> sources = make_sources();
+    std::string mode = (argc > 1) ? argv[1] : "";
+    if(mode == "list") {
+        for(auto &&s : sources) {
+            printf("%s\n", s.name.c_str());
+        }
+        return 0;
+    }
+
+    // select sources by name
+    std::vector<Source *> selected;
+    for(int i = 2; i < argc; ++i) {
+        auto it = std::find_if(sources.begin(), sources.end(), [&](const Source &s) { return s.name == argv[i]; });
+        if(it == sources.end()) {
+            fprintf(stderr, "Unknown source %s; run %s list to see them.\n", argv[i], argv[0]);
+            return -1;
+        }
+        selected.push_back(&*it);
+    }
+    if(argc == 2) {
+        for(auto &&s : sources) {
+            selected.push_back(&s);
+        }
+    }
+
+    if(mode == "practrand" && selected.size() == 1) {
+        std::vector<uint32_t> words(BLOCK_SIZE);
+        do {
+            selected[0]->fill(words.data());
+        } while(fwrite(words.data(), sizeof(uint32_t), words.size(), stdout) == words.size());
+        return 0;
+    }
+    if(mode != "small" && mode != "big") {
+        fprintf(stderr, "Usage: %s small|big [source ...]\n       %s practrand source\n       %s list\n", argv[0],
+                argv[0], argv[0]);
+        return -1;
+    }
+    std::vector<std::string> failed;
+    for(auto &&s : selected) {
+        if(!crush(*s, mode == "big")) {
+            failed.push_back(s->name);
+        }
+    }
+    printf("\n%zu of %zu sources failed\n", failed.size(), selected.size());
+    for(auto &&name : failed) {
+        printf("    %s\n", name.c_str());
+    }
+    return static_cast<int>(failed.size());
+}
@@ -0,0 +1,23 @@
+#include "../random.hpp"
+
+extern "C" {
+#include <unif01.h>
+#include <bbattery.h>
+};
+
+racutils::random::Random mrand;
+
+// transform to a uniform with the normal CDF
+double random_normal() {
+    return 0.5*erfc(-mrand.normal()/sqrt(2.0));
+}
+
+int main() {
+    unif01_Gen *gen;
+
+    gen = unif01_CreateExternGen01 ("Random-normal", random_normal);
+    bbattery_SmallCrush (gen);
+    unif01_DeleteExternGen01 (gen);
+
+    return 0;
+}
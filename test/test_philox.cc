@@ -0,0 +1,61 @@
+#include <cstdio>
+
+#include "../random.hpp"
+
+extern "C" {
+#include <unif01.h>
+#include <bbattery.h>
+};
+
+racutils::random::PhiloxRandom mrand;
+
+unsigned int engine() {
+    auto u = mrand.bits();
+    return (u>>32);
+}
+
+unsigned int engine_bswap() {
+    auto u = mrand.bits();
+    u = __builtin_bswap64(u);
+    return (u>>32);
+}
+
+// draws taken in counter order across many streams
+uint64_t counter = 0;
+unsigned int engine_streams() {
+    auto u = mrand.u64(counter % 1024, counter / 1024);
+    ++counter;
+    return (u>>32);
+}
+
+// known answers from the Random123 distribution
+bool known_answers() {
+    using racutils::random::details::Philox2x64;
+    auto a = Philox2x64::Block({0, 0}, 0);
+    auto b = Philox2x64::Block({~0ULL, ~0ULL}, ~0ULL);
+    return a[0] == 0xca00a0459843d731ULL && a[1] == 0x66c24222c9a845b5ULL &&
+           b[0] == 0x65b021d60cd8310fULL && b[1] == 0x4d02f3222f86df20ULL;
+}
+
+int main() {
+    if(!known_answers()) {
+        printf("Philox2x64-10 known answer test failed.\n");
+        return 1;
+    }
+
+    unif01_Gen *gen;
+
+    gen = unif01_CreateExternGenBits ("Philox-bits", engine);
+    bbattery_SmallCrush (gen);
+    unif01_DeleteExternGenBits (gen);
+
+    gen = unif01_CreateExternGenBits ("Philox-bits-bswap", engine_bswap);
+    bbattery_SmallCrush (gen);
+    unif01_DeleteExternGenBits (gen);
+
+    gen = unif01_CreateExternGenBits ("Philox-streams", engine_streams);
+    bbattery_SmallCrush (gen);
+    unif01_DeleteExternGenBits (gen);
+
+    return 0;
+}
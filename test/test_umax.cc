@@ -1,11 +1,11 @@
-#include "../minion.hpp"
+#include "../random.hpp"
 
 extern "C" {
 #include <unif01.h>
 #include <bbattery.h>
 };
 
-minion::Random mrand;
+racutils::random::Random mrand;
 
 double random_umax() {
     int64_t i = INT64_C(132799643625263);